@@ -18,6 +18,10 @@ my @headerDeclares = ();
 my @constructors = ();
 my @registerCalls = ();
 my @deconstructs = ();
+my @cfgDeclares = ();
+my @cfgSnapshots = ();
+my @cfgDefaults = ();
+my @cfgFrozenChecks = ();
 
 ##### START #####
 
@@ -34,6 +38,11 @@ if (-e $allknobs_c) {
   my $timestamp = stat($allknobs_c)->mtime;
   my $def_file_changed = 0;
 
+  # generated code changes with this script as well
+  if ($timestamp < stat($0)->mtime) {
+    $def_file_changed = 1;
+  }
+
   foreach my $file (@files) {
     if ($timestamp < stat($file)->mtime) {
       $def_file_changed = 1;
@@ -166,6 +175,17 @@ sub processLine
     push(@headerDeclares, "KnobTemplate< $datatype >* $KnobName;\n");
     push(@registerCalls,  "container->insertKnob( $KnobName );\n");
     push(@deconstructs,   "delete $KnobName;\n");
+
+    # config snapshot : every knob but strings
+    if (!($datatype =~ /string/)) {
+      push(@cfgDeclares,     "$datatype $KnobName;\n");
+      push(@cfgSnapshots,    "cfg->$KnobName = $KnobName->getValue();\n");
+      push(@cfgDefaults,     "constexpr $datatype ${KnobName}_DEFAULT = $defaultvalue;\n");
+      push(@cfgFrozenChecks, "if ($KnobName->getValue() != ${KnobName}_DEFAULT) {\n"
+                           . "\t\tstd::cerr << \"knob $paramfileentry is frozen to \" << ${KnobName}_DEFAULT << std::endl;\n"
+                           . "\t\tmatch = false;\n"
+                           . "\t}\n");
+    }
     if ($elements[2] =~ /\s*string\s*/) {
       if ($parentName ne "") {
         push(@constructors, "$KnobName = new KnobTemplate< $datatype > (\"$paramfileentry\", \"$defaultvalue\", \"$parentName\");\n");
@@ -191,7 +211,8 @@ sub processLine
 sub writeSource
 {
   print ALLKNOBS_C "#include \"all_knobs.h\"\n\n";
-  print ALLKNOBS_C "#include <string>\n\n";
+  print ALLKNOBS_C "#include <string>\n";
+  print ALLKNOBS_C "#include <iostream>\n\n";
 
   print ALLKNOBS_C "namespace cxlsim {\n\n";
   
@@ -217,6 +238,20 @@ sub writeSource
     print ALLKNOBS_C "\t$registerCall";
   }
   print ALLKNOBS_C "}\n\n";
+
+  #snapshot function
+  print ALLKNOBS_C "bool all_knobs_c::snapshot(knob_config_s *cfg) {\n";
+  foreach $snapshot (@cfgSnapshots) {
+    print ALLKNOBS_C "\t$snapshot";
+  }
+  print ALLKNOBS_C "\n\tbool match = true;\n";
+  print ALLKNOBS_C "#ifdef CXL_FROZEN_KNOBS\n";
+  foreach $check (@cfgFrozenChecks) {
+    print ALLKNOBS_C "\t$check";
+  }
+  print ALLKNOBS_C "#endif\n";
+  print ALLKNOBS_C "\treturn match;\n";
+  print ALLKNOBS_C "}\n\n";
   print ALLKNOBS_C "} // namespace cxlsim \n\n";
   
 }
@@ -235,6 +270,28 @@ sub writeHeader
 
 
   print ALLKNOBS_H "#define KNOB(var) m_simBase->m_knobs->var\n\n"; 
+
+  print ALLKNOBS_H "///////////////////////////////////////////////////////////////////////////////////////////////\n";
+  print ALLKNOBS_H "/// \\brief flat copy of the knobs (strings excluded), filled once at init\n";
+  print ALLKNOBS_H "///////////////////////////////////////////////////////////////////////////////////////////////\n";
+  print ALLKNOBS_H "typedef struct knob_config_s {\n";
+  foreach $vardef (@cfgDeclares) {
+    print ALLKNOBS_H "\t$vardef";
+  }
+  print ALLKNOBS_H "} knob_config_s;\n\n";
+
+  print ALLKNOBS_H "// default values in the param.def files\n";
+  foreach $vardef (@cfgDefaults) {
+    print ALLKNOBS_H "$vardef";
+  }
+  print ALLKNOBS_H "\n";
+
+  print ALLKNOBS_H "// hot path knob access : compile-time constants with frozen knobs\n";
+  print ALLKNOBS_H "#ifdef CXL_FROZEN_KNOBS\n";
+  print ALLKNOBS_H "#define CFG(var) (var##_DEFAULT)\n";
+  print ALLKNOBS_H "#else\n";
+  print ALLKNOBS_H "#define CFG(var) (m_simBase->m_cfg->var)\n";
+  print ALLKNOBS_H "#endif\n\n";
   
   print ALLKNOBS_H "///////////////////////////////////////////////////////////////////////////////////////////////\n";
   print ALLKNOBS_H "/// \\brief knob variables holder\n";
@@ -255,6 +312,11 @@ sub writeHeader
   print ALLKNOBS_H "\t\t * Register Knob Variables\n";
   print ALLKNOBS_H "\t\t */\n";
   print ALLKNOBS_H "\t\tvoid registerKnobs(KnobsContainer *container);\n\n";
+  print ALLKNOBS_H "\t\t/**\n";
+  print ALLKNOBS_H "\t\t * Copy knob values to cfg. With frozen knobs, returns false if\n";
+  print ALLKNOBS_H "\t\t * a knob was set to a value other than its default\n";
+  print ALLKNOBS_H "\t\t */\n";
+  print ALLKNOBS_H "\t\tbool snapshot(knob_config_s *cfg);\n\n";
   
   print ALLKNOBS_H "\tpublic:\n";
   foreach $vardef (@headerDeclares) {
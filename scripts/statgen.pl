@@ -23,6 +23,11 @@ if (-e $allstats and -e $statsEnums and -e $allstath) {
 
 	$def_file_changed = 0;
 
+	# generated code changes with this script as well
+	if ($timestamp < stat($0)->mtime) {
+		$def_file_changed = 1;
+	}
+
 	foreach $file (@files) {
 		if ($timestamp < stat($file)->mtime) {
 			$def_file_changed = 1;
@@ -47,6 +52,7 @@ print "./statgen.pl\n";
 @allstats_init_globalInit       = ();
 @allstats_init_globalSetup      = ();
 @allstats_init_globalCollection = ();
+@allstats_init_globalBind       = ();
 @allstats_init_coreInit         = ();
 @allstats_init_coreSetup        = ();
 @allstats_init_coreCollection   = ();
@@ -114,7 +120,9 @@ open(ALLSTATH, ">$allstath") || die("Can not open file $allstath\n");
 	print ALLSTATH "#ifndef _ALL_STATS_C_INCLUDED_\n";
 	print ALLSTATH "#define _ALL_STATS_C_INCLUDED_\n";
 	
-	print ALLSTATH "#include \"statistics.h\"\n\n";
+	print ALLSTATH "#include <cstdint>\n\n";
+	print ALLSTATH "#include \"statistics.h\"\n";
+	print ALLSTATH "#include \"statsEnums.h\"\n\n";
 
   print ALLSTATH "namespace cxlsim {\n\n";
 	
@@ -138,6 +146,9 @@ open(ALLSTATH, ">$allstath") || die("Can not open file $allstath\n");
       print ALLSTATH "\t\t * Constructor\n";
       print ALLSTATH "\t\t */\n";
 			print ALLSTATH "\t\tvoid initialize(ProcessorStatistics\*, CoreStatistics\*);\n\n";
+
+			#flat counter array : STAT_EVENT increments, stat objects read it at dump time
+			print ALLSTATH "\t\tuint64_t\* m_counters; /**< global stat counters (cache-aligned) */\n\n";
 		
 			#member stat variables
 			for $declares (@allstats_declare) {
@@ -155,6 +166,8 @@ close(ALLSTATH);
 ##### all_stats.cc #####
 open(ALLSTATS, ">$allstats") || die("Can not open file $allstats\n");
 	
+	print ALLSTATS "#include <cstdlib>\n";
+	print ALLSTATS "#include <cstring>\n\n";
 	print ALLSTATS "#include \"all_stats.h\"\n";
 	print ALLSTATS "#include \"statsEnums.h\"\n\n";
 
@@ -162,12 +175,19 @@ open(ALLSTATS, ">$allstats") || die("Can not open file $allstats\n");
 	
 	#constructor
 	print ALLSTATS "all_stats_c::all_stats_c(ProcessorStatistics\* procStat) {\n";
+	print ALLSTATS "\tvoid\* counters = NULL;\n";
+	print ALLSTATS "\tif (posix_memalign(&counters, 64, sizeof(uint64_t) \* GLOBAL_STATS_COUNT) != 0) {\n";
+	print ALLSTATS "\t\tabort();\n";
+	print ALLSTATS "\t}\n";
+	print ALLSTATS "\tm_counters = static_cast<uint64_t\*>(counters);\n";
+	print ALLSTATS "\tmemset(m_counters, 0, sizeof(uint64_t) \* GLOBAL_STATS_COUNT);\n";
 		for $construct (@allstats_constructor) {print ALLSTATS "\t".$construct;}
 	print ALLSTATS "}\n\n";
 	
 	#destructor
 	print ALLSTATS "all_stats_c::\~all_stats_c() {\n";
 		for $deconst (@allstats_deconstruct) {print ALLSTATS "\t".$deconst;}
+	print ALLSTATS "\tfree(m_counters);\n";
 	print ALLSTATS "}\n\n";
 	
 	#initialization and configuration
@@ -178,6 +198,8 @@ open(ALLSTATS, ">$allstats") || die("Can not open file $allstats\n");
 		print ALLSTATS "\n\n";
 		for $initLine (@allstats_init_globalCollection) {print ALLSTATS "\t".$initLine;}
 		print ALLSTATS "\n\n";
+		for $initLine (@allstats_init_globalBind)       {print ALLSTATS "\t".$initLine;}
+		print ALLSTATS "\n\n";
 		for $initLine (@allstats_init_coreInit)         {print ALLSTATS "\t".$initLine;}
 		print ALLSTATS "\n\n";
 		for $initLine (@allstats_init_coreSetup)        {print ALLSTATS "\t".$initLine;}
@@ -205,6 +227,7 @@ close (ALLSTATS);
 	print ENUMDEF "enum StatisticsEnum\n{\n";
 	
 	foreach $defLine (@StatisticsEnum) {print ENUMDEF $defLine;}
+	print ENUMDEF "GLOBAL_STATS_COUNT,\n";
 	print ENUMDEF "\n\n";
 	foreach $defLine (@coreStatsEnum) {print ENUMDEF $defLine;}
 	
@@ -486,6 +509,7 @@ sub defineDistributionMember
 	else {
 		push (@allstats_init_globalInit, "$StatsContainer->addStatistic($variableName);\n");
 		push (@allstats_init_globalSetup, "$distributionVariable->addMember($StatName);\n");
+		push (@allstats_init_globalBind, "$variableName->bindCounter(&m_counters[$StatName]);\n");
 	}
 	# 	printf "$definition\n";
 }
@@ -526,6 +550,7 @@ sub defineRatioStatistic
 	}
 	else {
 		push (@allstats_init_globalInit, "$StatsContainer->addStatistic($variableName);\n");
+		push (@allstats_init_globalBind, "$variableName->bindCounter(&m_counters[$StatName]);\n");
 	}
 	# 	printf "$definition\n";
 }
@@ -566,6 +591,7 @@ sub defineStatistic
 	}
 	else {
 		push (@allstats_init_globalInit, "$StatsContainer->addStatistic($variableName);\n");
+		push (@allstats_init_globalBind, "$variableName->bindCounter(&m_counters[$StatName]);\n");
 	}
 
 	# 	printf "$definition\n";
@@ -0,0 +1,305 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : bench.cc
+ * Description  : microbenchmarks of the simulator hot paths
+ *********************************************************************************************/
+
+// usage : cxlsim_bench [knobs]  (run from a directory holding the ramulator config)
+// - every benchmark reports wall ns per operation; compare numbers from the
+//   same machine & knobs only
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <list>
+
+#include "cxlsim.h"
+#include "pcie_endpoint.h"
+#include "pcie_rc.h"
+#include "pcie_vcbuff.h"
+#include "packet_info.h"
+#include "utils.h"
+#include "Callback.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+/////////////////////////////////////////////////////////////////////////////
+
+typedef std::chrono::steady_clock bench_clock_t;
+
+static const Counter POOL_OPS = 4000000;
+static const Counter FLIT_GEN_CYCLES = 200000;
+static const Counter LOOPBACK_CYCLES = 200000;
+static const Counter E2E_REQS = 200000;
+static const Counter E2E_OUTSTANDING = 64; /**< host mshrs */
+static const int POOL_BATCH = 64;
+
+static double elapsed_ns(bench_clock_t::time_point start) {
+  return std::chrono::duration<double, std::nano>(bench_clock_t::now() - start).count();
+}
+
+static void report(const std::string& name, Counter ops, const std::string& unit,
+                   double ns) {
+  std::cout << std::left << std::setw(32) << name
+            << std::right << std::setw(12) << ops << " " << std::left
+            << std::setw(8) << unit << std::right << std::fixed
+            << std::setprecision(2) << std::setw(12) << (ops ? ns / ops : 0.0)
+            << " ns/op" << std::endl;
+}
+
+// pseudo random cacheline addresses (xorshift)
+static Addr next_addr(Addr& state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return (state & 0xffffffc0ULL);
+}
+
+// write every write_every-th request (0 : reads only)
+static bool is_write(Counter seq, int write_every) {
+  return (write_every > 0) && (seq % write_every == 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// packet pools shared by the benchmarked endpoints
+typedef struct bench_pools_s {
+  bench_pools_s(cxlsim_c* simBase) : m_simBase(simBase) {}
+
+  cxl_req_s* acquire_req(Counter id, Addr addr, bool write) {
+    cxl_req_s* req = m_req_pool.acquire_entry(m_simBase);
+    req->m_id = id;
+    req->m_addr = addr;
+    req->m_write = write;
+    return req;
+  }
+
+  void release_req(cxl_req_s* req) {
+    req->init();
+    m_req_pool.release_entry(req);
+  }
+
+  pool_c<cxl_req_s> m_req_pool;
+  pool_c<message_s> m_msg_pool;
+  pool_c<slot_s> m_slot_pool;
+  pool_c<flit_s> m_flit_pool;
+  cxlsim_c* m_simBase;
+} bench_pools_s;
+
+// device that returns every request as soon as it is pulled from the rx vc
+class echo_ep_c : public pcie_ep_c
+{
+public:
+  echo_ep_c(cxlsim_c* simBase) : pcie_ep_c(simBase) {}
+
+private:
+  void start_transaction() override {
+    while (!m_resp_q.empty() && push_txvc(m_resp_q.front())) {
+      m_resp_q.pop_front();
+    }
+  }
+
+  void end_transaction() override {
+    while (cxl_req_s* req = pull_rxvc()) {
+      m_resp_q.push_back(req);
+    }
+  }
+
+private:
+  std::list<cxl_req_s*> m_resp_q;
+};
+
+// counts completions of cxlsim_c
+class bench_host_c {
+public:
+  bench_host_c() : m_done(0) {}
+
+  void done_cb(Addr, bool, Counter, void*) {
+    m_done++;
+  }
+
+  Counter m_done;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+// acquire & release entries in batches
+static void bench_pool(cxlsim_c* simBase) {
+  pool_c<message_s> pool;
+  message_s* batch[POOL_BATCH];
+
+  auto start = bench_clock_t::now();
+  for (Counter ii = 0; ii < POOL_OPS / POOL_BATCH; ++ii) {
+    for (int jj = 0; jj < POOL_BATCH; ++jj) {
+      batch[jj] = pool.acquire_entry(simBase);
+    }
+    for (int jj = 0; jj < POOL_BATCH; ++jj) {
+      batch[jj]->init();
+      pool.release_entry(batch[jj]);
+    }
+  }
+  report("pool_c acquire+release", POOL_OPS, "entries", elapsed_ns(start));
+}
+
+// keep the tx vc full & pack flits every cycle, the link drains instantly
+static void bench_flit_gen(cxlsim_c* simBase, const std::string& name, 
+                           int write_every) {
+  bench_pools_s pools(simBase);
+  vc_buff_c vc(simBase);
+  vc.init(TX, true, &pools.m_msg_pool, &pools.m_slot_pool, &pools.m_flit_pool,
+          8, 8);
+
+  Addr state = 0x12345;
+  Counter seq = 0;
+  Counter flits = 0;
+  double ns = 0.0;
+  for (Counter cycle = 0; cycle < FLIT_GEN_CYCLES; ++cycle) {
+    while (!vc.flit_full()) {
+      ++seq;
+      cxl_req_s* req = pools.acquire_req(seq, next_addr(state), 
+                                         is_write(seq, write_every));
+      if (vc.full(vc.get_channel(req))) {
+        pools.release_req(req);
+        break;
+      }
+      vc.insert(req);
+    }
+
+    auto start = bench_clock_t::now();
+    vc.generate_flits();
+    ns += elapsed_ns(start);
+    vc.run_a_cycle();
+
+    // release flits as the receiving endpoint would
+    while (flit_s* flit = vc.peek_flit()) {
+      vc.pop_flit();
+      flits++;
+      for (auto slot : flit->m_slots) {
+        for (auto msg : slot->m_msgs) {
+          if (!msg->m_data) {
+            pools.release_req(msg->m_req);
+          }
+          msg->init();
+          pools.m_msg_pool.release_entry(msg);
+        }
+        slot->init();
+        pools.m_slot_pool.release_entry(slot);
+      }
+      flit->init();
+      pools.m_flit_pool.release_entry(flit);
+    }
+  }
+  report("generate_flits " + name, flits, "flits", ns);
+}
+
+// root complex & echo device at saturation : no dram in the loop
+static void bench_loopback(cxlsim_c* simBase, const std::string& name,
+                           int write_every) {
+  bench_pools_s pools(simBase);
+  pcie_rc_c rc(simBase);
+  echo_ep_c ep(simBase);
+  rc.init(0, 0, true, &pools.m_msg_pool, &pools.m_slot_pool, &pools.m_flit_pool, &ep);
+  ep.init(1, 0, false, &pools.m_msg_pool, &pools.m_slot_pool, &pools.m_flit_pool, &rc);
+
+  Addr state = 0x6789;
+  Counter seq = 0;
+  Counter done = 0;
+  auto start = bench_clock_t::now();
+  for (Counter cycle = 0; cycle < LOOPBACK_CYCLES; ++cycle) {
+    while (!rc.rootcomplex_full()) {
+      ++seq;
+      rc.insert_request(pools.acquire_req(seq, next_addr(state), 
+                                          is_write(seq, write_every)));
+    }
+
+    ep.run_a_cycle(false);
+    rc.run_a_cycle(false);
+
+    while (cxl_req_s* req = rc.pop_request()) {
+      pools.release_req(req);
+      done++;
+    }
+  }
+  double ns = elapsed_ns(start);
+  report("loopback " + name, LOOPBACK_CYCLES, "cycles", ns);
+  report("loopback " + name, done, "reqs", ns);
+}
+
+// requests through the full simulator (rc, link, mxp & dram backend)
+// - outstanding requests are bounded like a host with a fixed number of mshrs
+static void bench_e2e(cxlsim_c* simBase, const std::string& name, 
+                      int write_every) {
+  bench_host_c host;
+  callback_t* cb = new Callback<bench_host_c, void, Addr, bool, Counter, void*>
+                                (&host, &bench_host_c::done_cb);
+  simBase->register_callback(cb);
+
+  Addr state = 0xabcdef;
+  Counter seq = 0;
+  Counter cycles = 0;
+  auto start = bench_clock_t::now();
+  while (host.m_done < E2E_REQS) {
+    while (seq < E2E_REQS && seq - host.m_done < E2E_OUTSTANDING &&
+           simBase->insert_request(next_addr(state), is_write(seq + 1, write_every), 
+                                   NULL)) {
+      seq++;
+    }
+    simBase->run_a_cycle(false);
+    cycles++;
+  }
+  double ns = elapsed_ns(start);
+  report("cxlsim_c " + name, E2E_REQS, "reqs", ns);
+  report("cxlsim_c " + name, cycles, "cycles", ns);
+
+  simBase->register_callback(NULL);
+  delete cb;
+}
+
+} // namespace CXL
+
+int main(int argc, char** argv) {
+  using namespace cxlsim;
+
+  cxlsim_c* simBase = new cxlsim_c();
+  simBase->init(argc, argv);
+
+  bench_pool(simBase);
+  bench_flit_gen(simBase, "read", 0);
+  bench_flit_gen(simBase, "write", 1);
+  bench_flit_gen(simBase, "mix 2:1", 3);
+  bench_loopback(simBase, "read", 0);
+  bench_loopback(simBase, "write", 1);
+  bench_loopback(simBase, "mix 2:1", 3);
+  bench_e2e(simBase, "mix 2:1", 3);
+
+  delete simBase;
+  return 0;
+}
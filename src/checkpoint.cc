@@ -0,0 +1,219 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : checkpoint.cc
+ * Description  : Binary checkpoint of the simulator state
+ *********************************************************************************************/
+
+#include <cstring>
+#include <cassert>
+
+#include "checkpoint.h"
+#include "packet_info.h"
+#include "utils.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+// index of m_ids & m_objs of each packet type
+#define CKPT_REQ 0
+#define CKPT_MSG 1
+#define CKPT_SLOT 2
+#define CKPT_FLIT 3
+
+checkpoint_c::checkpoint_c(cxlsim_c* simBase, pool_c<cxl_req_s>* req_pool,
+                           pool_c<message_s>* msg_pool, 
+                           pool_c<slot_s>* slot_pool,
+                           pool_c<flit_s>* flit_pool) {
+  m_simBase = simBase;
+  m_save = true;
+  m_req_pool = req_pool;
+  m_msg_pool = msg_pool;
+  m_slot_pool = slot_pool;
+  m_flit_pool = flit_pool;
+
+  // without translation the pointer value is the tag (same process only)
+  m_save_tag = [](void* req) { return reinterpret_cast<uint64_t>(req); };
+  m_load_tag = [](uint64_t tag) { return reinterpret_cast<void*>(tag); };
+}
+
+bool checkpoint_c::open(const std::string& path, bool save) {
+  m_save = save;
+  m_stream.open(path.c_str(), (save ? std::ios::out | std::ios::trunc : std::ios::in) | 
+                              std::ios::binary);
+  return m_stream.is_open();
+}
+
+bool checkpoint_c::close() {
+  bool good = m_stream.good();
+  m_stream.close();
+  return good;
+}
+
+void checkpoint_c::set_tags(ckpt_save_tag_t save_tag, ckpt_load_tag_t load_tag) {
+  if (save_tag) {
+    m_save_tag = save_tag;
+  }
+  if (load_tag) {
+    m_load_tag = load_tag;
+  }
+}
+
+void checkpoint_c::io(std::string& str) {
+  uint64_t size = str.size();
+  io(size);
+  if (m_save) {
+    m_stream.write(str.data(), size);
+  } else {
+    str.resize(size);
+    m_stream.read(&str[0], size);
+  }
+}
+
+void checkpoint_c::mark(const char* name) {
+  std::string str(name);
+  std::string read = str;
+  io(read);
+  ASSERTM(read == str, "checkpoint does not match this simulator build\n");
+}
+
+template <typename T>
+bool checkpoint_c::io_ref(T*& ptr, pool_c<T>* pool, std::map<void*, int64>& ids,
+                          std::vector<void*>& objs) {
+  int64 id = -1;
+  if (m_save) {
+    if (ptr != NULL) {
+      auto iter = ids.find(ptr);
+      if (iter != ids.end()) {
+        id = iter->second;
+        io(id);
+        return false;
+      }
+      id = objs.size();
+      ids[ptr] = id;
+      objs.push_back(ptr);
+    }
+    io(id);
+    return (ptr != NULL);
+  }
+
+  io(id);
+  if (id < 0 || !m_stream.good()) {
+    ptr = NULL;
+    return false;
+  }
+  if (id < (int64)objs.size()) {
+    ptr = static_cast<T*>(objs[id]);
+    return false;
+  }
+
+  assert(id == (int64)objs.size());
+  ptr = pool->acquire_entry(m_simBase);
+  ptr->init();
+  objs.push_back(ptr);
+  return true;
+}
+
+void checkpoint_c::io(cxl_req_s*& req) {
+  if (!io_ref(req, m_req_pool, m_ids[CKPT_REQ], m_objs[CKPT_REQ])) {
+    return;
+  }
+
+  // m_traced is not kept : the trace of a restored run starts with new requests
+  uint64_t tag = m_save ? m_save_tag(req->m_req) : 0;
+  io(tag);
+  if (!m_save) {
+    req->m_req = m_load_tag(tag);
+  }
+
+  io(req->m_id);
+  io(req->m_addr);
+  io(req->m_write);
+  io(req->m_host);
+  io(req->m_dpa);
+  io(req->m_issue_cycle);
+  io(req->m_early_done);
+  io(req->m_devload);
+  io(req->m_trace_cycle);
+}
+
+void checkpoint_c::io(message_s*& msg) {
+  if (!io_ref(msg, m_msg_pool, m_ids[CKPT_MSG], m_objs[CKPT_MSG])) {
+    return;
+  }
+
+  io(msg->m_id);
+  io(msg->m_bits);
+  io(msg->m_type);
+  io(msg->m_data);
+  io(msg->m_parent);
+  io(msg->m_childs);
+  io(msg->m_arrived_child);
+  io(msg->m_chunk);
+  io(msg->m_critical);
+  io(msg->m_txvc_insert_start);
+  io(msg->m_txvc_insert_done);
+  io(msg->m_rxvc_insert_start);
+  io(msg->m_rxvc_insert_done);
+  io(msg->m_vc_id);
+  io(msg->m_req);
+}
+
+void checkpoint_c::io(slot_s*& slot) {
+  if (!io_ref(slot, m_slot_pool, m_ids[CKPT_SLOT], m_objs[CKPT_SLOT])) {
+    return;
+  }
+
+  io(slot->m_id);
+  io(slot->m_bits);
+  io(slot->m_head);
+  io(slot->m_type);
+  io(slot->m_msg_cnt);
+  io(slot->m_msgs);
+}
+
+void checkpoint_c::io(flit_s*& flit) {
+  if (!io_ref(flit, m_flit_pool, m_ids[CKPT_FLIT], m_objs[CKPT_FLIT])) {
+    return;
+  }
+
+  io(flit->m_id);
+  io(flit->m_bits);
+  io(flit->m_phys_sent);
+  io(flit->m_flit_gen_cycle);
+  io(flit->m_txreplay_insert_start);
+  io(flit->m_txreplay_insert_done);
+  io(flit->m_phys_start);
+  io(flit->m_phys_done);
+  io(flit->m_rxdll_done);
+  io(flit->m_msg_cnt);
+  io(flit->m_slots);
+}
+
+} // namespace CXL
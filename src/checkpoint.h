@@ -0,0 +1,204 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : checkpoint.h
+ * Description  : Binary checkpoint of the simulator state
+ *********************************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "cxlsim.h"
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+// archive of the simulator state. every component has a checkpoint()
+// doing the same io() calls for both directions : they write the state when
+// saving and read it back into the freshly built objects when restoring.
+// packets are written as ids, the packet itself follows its first
+// reference so that shared packets (m_parent, m_req, ...) stay shared
+class checkpoint_c {
+public:
+  /**
+   * Constructor
+   */
+  checkpoint_c(cxlsim_c* simBase, pool_c<cxl_req_s>* req_pool,
+               pool_c<message_s>* msg_pool, pool_c<slot_s>* slot_pool,
+               pool_c<flit_s>* flit_pool);
+
+  /**
+   * Open a checkpoint file (save : write, otherwise read)
+   */
+  bool open(const std::string& path, bool save);
+
+  /**
+   * Close the file, returns false if any io failed
+   */
+  bool close();
+
+  /**
+   * Saving or restoring
+   */
+  bool saving() { return m_save; }
+
+  /**
+   * Set the translation of outer simulator request pointers
+   */
+  void set_tags(ckpt_save_tag_t save_tag, ckpt_load_tag_t load_tag);
+
+  /**
+   * Plain values (integers, floats, enums & arrays of them)
+   */
+  template <typename T>
+  void io(T& val) {
+    static_assert(std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value,
+                  "only plain values are written as they are");
+    if (m_save) {
+      m_stream.write(reinterpret_cast<char*>(&val), sizeof(T));
+    } else {
+      m_stream.read(reinterpret_cast<char*>(&val), sizeof(T));
+    }
+  }
+
+  /**
+   * Containers
+   */
+  template <typename T>
+  void io(std::list<T>& list) {
+    uint64_t size = list.size();
+    io(size);
+    if (m_save) {
+      for (auto& elem : list) {
+        io(elem);
+      }
+    } else {
+      list.clear();
+      for (uint64_t ii = 0; ii < size && m_stream.good(); ++ii) {
+        list.push_back(T());
+        io(list.back());
+      }
+    }
+  }
+
+  template <typename T>
+  void io(std::vector<T>& vec) {
+    uint64_t size = vec.size();
+    io(size);
+    if (!m_save) {
+      vec.resize(size);
+    }
+    for (auto& elem : vec) {
+      io(elem);
+    }
+  }
+
+  template <typename K, typename V>
+  void io(std::map<K, V>& map) {
+    uint64_t size = map.size();
+    io(size);
+    if (m_save) {
+      for (auto& elem : map) {
+        K key = elem.first;
+        io(key);
+        io(elem.second);
+      }
+    } else {
+      map.clear();
+      for (uint64_t ii = 0; ii < size && m_stream.good(); ++ii) {
+        K key;
+        io(key);
+        io(map[key]);
+      }
+    }
+  }
+
+  template <typename A, typename B>
+  void io(std::pair<A, B>& pair) {
+    io(pair.first);
+    io(pair.second);
+  }
+
+  void io(std::string& str);
+
+  /**
+   * Packets
+   */
+  void io(cxl_req_s*& req);
+  void io(message_s*& msg);
+  void io(slot_s*& slot);
+  void io(flit_s*& flit);
+
+  /**
+   * Section marker : catches components reading what others wrote
+   */
+  void mark(const char* name);
+
+private:
+  checkpoint_c(); // do not implement
+
+  /**
+   * Write or read the id of a packet, returns true if the packet itself has
+   * to follow (first reference)
+   */
+  template <typename T>
+  bool io_ref(T*& ptr, pool_c<T>* pool, std::map<void*, int64>& ids,
+              std::vector<void*>& objs);
+
+private:
+  cxlsim_c* m_simBase;
+  bool m_save; /**< saving (otherwise restoring) */
+  std::fstream m_stream; /**< checkpoint file */
+
+  pool_c<cxl_req_s>* m_req_pool;
+  pool_c<message_s>* m_msg_pool;
+  pool_c<slot_s>* m_slot_pool;
+  pool_c<flit_s>* m_flit_pool;
+
+  // id of every packet written (save) & packet of every id read (restore)
+  std::map<void*, int64> m_ids[4];
+  std::vector<void*> m_objs[4];
+
+  ckpt_save_tag_t m_save_tag; /**< request pointer -> tag */
+  ckpt_load_tag_t m_load_tag; /**< tag -> request pointer */
+};
+
+} // namespace CXL
+#endif // CHECKPOINT_H
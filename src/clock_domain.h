@@ -0,0 +1,118 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : clock_domain.h
+ * Description  : Clock domain on a picosecond timebase
+ *********************************************************************************************/
+
+#ifndef CLOCK_DOMAIN_H
+#define CLOCK_DOMAIN_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "global_types.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+#define PS_PER_HZ_CYCLE 1000000000000ULL /**< one cycle at 1 Hz in ps */
+
+// edges of a clock on the picosecond timebase. the period rarely is a whole
+// number of ps (1.2 GHz : 833.33 ps), so edge k is kept at exactly
+// floor(k * 1e12 / freq_hz) ps by carrying the fractional part, i.e. no
+// drift however long the run & no restriction on the frequency pairs
+class clock_domain_c {
+public:
+  clock_domain_c() {
+    init(1.0);
+  }
+
+  /**
+   * Set the frequency (GHz, resolved to Hz) & restart at time 0
+   */
+  void init(double freq_ghz) {
+    m_freq_hz = static_cast<uint64_t>(std::llround(freq_ghz * 1e9));
+    ASSERTM(m_freq_hz > 0, "clock frequency must be positive\n");
+    m_period_ps = PS_PER_HZ_CYCLE / m_freq_hz;
+    m_period_frac = PS_PER_HZ_CYCLE % m_freq_hz;
+    m_next_ps = 0;
+    m_next_frac = 0;
+    m_count = 0;
+  }
+
+  /**
+   * Time of the next edge (ps)
+   */
+  uint64_t next() const {
+    return m_next_ps;
+  }
+
+  /**
+   * Edges so far
+   */
+  Counter count() const {
+    return m_count;
+  }
+
+  /**
+   * Move to the following edge
+   */
+  void advance() {
+    m_next_ps += m_period_ps;
+    m_next_frac += m_period_frac;
+    if (m_next_frac >= m_freq_hz) {
+      m_next_frac -= m_freq_hz;
+      m_next_ps++;
+    }
+    m_count++;
+  }
+
+  /**
+   * State for checkpoints (the frequency comes from the knobs)
+   */
+  template <typename T>
+  void checkpoint(T* ckpt) {
+    ckpt->io(m_next_ps);
+    ckpt->io(m_next_frac);
+    ckpt->io(m_count);
+  }
+
+private:
+  uint64_t m_freq_hz; /**< frequency */
+  uint64_t m_period_ps; /**< whole ps of the period */
+  uint64_t m_period_frac; /**< fraction of a ps of the period, in 1/m_freq_hz */
+  uint64_t m_next_ps; /**< whole ps of the next edge */
+  uint64_t m_next_frac; /**< fraction of a ps of the next edge, in 1/m_freq_hz */
+  Counter m_count; /**< edges so far */
+};
+
+} // namespace CXL
+
+#endif // CLOCK_DOMAIN_H
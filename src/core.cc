@@ -39,7 +39,9 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "all_knobs.h"
 #include "cxlsim.h"
+#include "checkpoint.h"
 #include "core.h"
+#include "assert_macros.h"
 
 namespace cxlsim {
 
@@ -49,14 +51,16 @@ core_req_s::core_req_s() {
   init();
 }
 
-core_req_s::core_req_s(Addr addr, bool write) {
+core_req_s::core_req_s(Addr addr, bool write, int host) {
   m_addr = addr;
   m_write = write;
+  m_host = host;
 }
 
 void core_req_s::init() {
   m_addr = 0;
   m_write = false;
+  m_host = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -66,12 +70,19 @@ core_c::core_c(cxlsim_c* simBase) {
   m_return_reqs = 0;
   m_insert_reqs = 0;
   m_cycle = 0;
+  m_trace_pos = 0;
 
   callback_t *trans_callback = 
     new Callback<core_c, void, Addr, bool, Counter, void*>
                 (&(*this), &core_c::core_callback);
 
   m_simBase->register_callback(trans_callback);
+
+  // the callback only counts & frees the request, so a restored request
+  // needs no identity
+  m_simBase->register_checkpoint_tags(
+    [](void*) { return (uint64_t)0; },
+    [](uint64_t) { return (void*)new core_req_s(); });
 }
 
 core_c::~core_c() {
@@ -82,12 +93,12 @@ void core_c::set_tracefile(std::string filename) {
   m_tracefilename = filename;
 }
 
-void core_c::insert_request(Addr addr, bool write, Counter cycle) {
-  core_req_s* new_req = new core_req_s(addr, write);
+void core_c::insert_request(Addr addr, bool write, Counter cycle, int host) {
+  core_req_s* new_req = new core_req_s(addr, write, host);
   m_pending_q.push_back({new_req, cycle});
 
   // debug messages
-  if (m_simBase->m_knobs->KNOB_DEBUG_CALLBACK->getValue()) {
+  if (CFG(KNOB_DEBUG_CALLBACK)) {
     std::cout << "======================== insert core req =================================" << std::endl;
     std::cout << m_insert_reqs << " " << addr << " " << write << " " << new_req << std::endl;
     m_insert_reqs++;
@@ -104,10 +115,12 @@ void core_c::run_a_cycle(bool pll_locked) {
 
     if (cycle == m_cycle) {
       Counter req_id = 
-        m_simBase->insert_request(req->m_addr, req->m_write, (void*)req);
+        m_simBase->insert_request(req->m_addr, req->m_write, (void*)req,
+                                  req->m_host);
 
       if (req_id != 0) {
         m_pending_q.pop_front();
+        m_trace_pos++;
       }
     }
   }
@@ -128,24 +141,59 @@ void core_c::run_sim() {
         int type;
         Counter cycle;
         bool write;
+        int host = 0;
 
-        std::sscanf(line.c_str(), "%llu %d %llu", &addr, &type, &cycle);
+        // optional 4th column : issuing host (num_hosts)
+        std::sscanf(line.c_str(), "%llu %d %llu %d", &addr, &type, &cycle, &host);
+        ASSERTM(host >= 0, "trace host id should not be negative\n");
         write = (type == 1);
-        insert_request(addr, write, cycle);
+        insert_request(addr, write, cycle, host % m_simBase->m_num_hosts);
         tot_reqs++;
       }
     file.close();
   }
 
+  // restore a warmed-up state : skip the requests inserted before it
+  auto ckpt_fn = [this](checkpoint_c* ckpt) { checkpoint(ckpt); };
+  std::string load_file = m_simBase->m_knobs->KNOB_CKPT_LOAD_FILE->getValue();
+  if (load_file != "none") {
+    bool loaded = m_simBase->load_checkpoint(load_file, ckpt_fn);
+    ASSERTM(loaded, "cannot read ckpt_load_file\n");
+
+    for (Counter ii = 0; ii < m_trace_pos && !m_pending_q.empty(); ++ii) {
+      delete m_pending_q.front().first;
+      m_pending_q.pop_front();
+    }
+    std::cout << "Checkpoint restored at cycle " << m_cycle << std::endl;
+  }
+
+  // checkpoint at the first cycle from ckpt_save_cycle on with the dram idle
+  Counter save_cycle = CFG(KNOB_CKPT_SAVE_CYCLE);
+  bool saved = (save_cycle == 0 || load_file != "none");
+
   // run simulation
-  while (m_return_reqs < tot_reqs) {
+  m_simBase->set_total_reqs(tot_reqs - m_return_reqs);
+  while (m_return_reqs < tot_reqs && !m_simBase->sampling_done()) {
     run_a_cycle(false);
+
+    if (!saved && m_cycle >= save_cycle && m_simBase->checkpoint_ready()) {
+      std::string save_file = m_simBase->m_knobs->KNOB_CKPT_SAVE_FILE->getValue();
+      saved = m_simBase->save_checkpoint(save_file, ckpt_fn);
+      ASSERTM(saved, "cannot write ckpt_save_file\n");
+      std::cout << "Checkpoint saved at cycle " << m_cycle << std::endl;
+    }
   }
   std::cout << "Simulation ended" << std::endl;
 }
 
+void core_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_cycle);
+  ckpt->io(m_return_reqs);
+  ckpt->io(m_trace_pos);
+}
+
 void core_c::core_callback(Addr addr, bool write, Counter req_id, void *req) {
-  if (m_simBase->m_knobs->KNOB_DEBUG_CALLBACK->getValue()) {
+  if (CFG(KNOB_DEBUG_CALLBACK)) {
     std::cout << "======================== core callback =================================" << std::endl;
     std::cout << m_return_reqs << " " << addr << " " << write << " " << req << std::endl;
   }
@@ -52,11 +52,12 @@ namespace cxlsim {
 // example message struct sent from core to cxl
 typedef struct core_req_s {
   core_req_s();
-  core_req_s(Addr addr, bool write);
+  core_req_s(Addr addr, bool write, int host);
   void init();
 
   Addr m_addr;
   bool m_write;
+  int m_host;
 } core_req_s;
 
 /////////////////////////////////////////////////////////////////////////////
@@ -68,12 +69,13 @@ public:
   ~core_c();
 
   void set_tracefile(std::string filename);
-  void insert_request(Addr addr, bool write, Counter cycle);
+  void insert_request(Addr addr, bool write, Counter cycle, int host);
   void run_a_cycle(bool pll_locked);
   void run_sim();
 
 private:
   void core_callback(Addr addr, bool write, Counter req_id, void *req);
+  void checkpoint(checkpoint_c* ckpt); /**< save or restore the trace cursor */
 
 public:
   // for debugging
@@ -83,6 +85,7 @@ public:
   // simbase
   cxlsim_c* m_simBase;
   Counter m_cycle;
+  Counter m_trace_pos; /**< trace requests inserted to cxlsim */
 
 private:
   std::string m_tracefilename;
@@ -0,0 +1,401 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : cxl_switch.cc
+ * Description  : CXL switch between the root complexes and the memory expanders
+ *********************************************************************************************/
+
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <cassert>
+
+#include "cxl_switch.h"
+#include "cxlsim.h"
+#include "packet_info.h"
+#include "trace_event.h"
+#include "checkpoint.h"
+
+#include "all_knobs.h"
+#include "all_stats.h"
+#include "statistics.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+cxl_switch_c::cxl_switch_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  m_num_usp = CFG(KNOB_NUM_HOSTS);
+  m_num_dsp = CFG(KNOB_SWITCH_NUM_DEVICES);
+  m_num_ports = m_num_usp + m_num_dsp;
+  ASSERTM(m_num_dsp > 0, "switch_num_devices should be at least 1\n");
+
+  for (int ii = 0; ii < m_num_ports; ++ii) {
+    m_ports.push_back(new switch_port_c(simBase, this, ii));
+  }
+
+  m_ingress_cap = CFG(KNOB_SWITCH_INGRESS_CAPACITY);
+  m_ingress.resize(m_num_ports);
+  m_last_grant.resize(m_num_ports, m_num_ports - 1);
+  m_port_stats.resize(m_num_ports, switch_port_stat_s{0, 0, 0, 0});
+
+  // cut-through starts forwarding once the header flit is in, so the
+  // flits carrying the rest of the message overlap with the switch latency
+  m_latency = CFG(KNOB_SWITCH_LATENCY);
+  m_cut_through = CFG(KNOB_SWITCH_CUT_THROUGH);
+  m_data_slots = CFG(KNOB_RAMULATOR_CACHELINE_SIZE) * 8 / CFG(KNOB_PCIE_DATA_MSG_BITS);
+  m_slots_per_flit = CFG(KNOB_PCIE_SLOTS_PER_FLIT);
+
+  m_arb = MAX_SWITCH_ARB_TYPES;
+  std::string arb = *KNOB(KNOB_SWITCH_ARB);
+  for (int ii = 0; ii < MAX_SWITCH_ARB_TYPES; ++ii) {
+    if (arb == switch_arb_string[ii]) {
+      m_arb = static_cast<SWITCH_ARB_TYPE>(ii);
+    }
+  }
+  ASSERTM(m_arb != MAX_SWITCH_ARB_TYPES, "unknown switch_arb\n");
+
+  init_decoders();
+  m_cycle = 0;
+}
+
+cxl_switch_c::~cxl_switch_c() {
+  for (auto port : m_ports) {
+    delete port;
+  }
+}
+
+// each entry of switch_hdm_decoders is base:size:gran:dev,dev,...
+// - ranges of the decoders sharing a device are stacked in its dpa space
+void cxl_switch_c::init_decoders() {
+  std::string decoders = *KNOB(KNOB_SWITCH_HDM_DECODERS);
+  if (decoders == "none") {
+    hdm_decoder_s dec;
+    dec.m_base = 0;
+    dec.m_size = 0;
+    dec.m_gran = CFG(KNOB_SWITCH_INTLV_GRAN);
+    dec.m_dpa_base = 0;
+    for (int ii = 0; ii < m_num_dsp; ++ii) {
+      dec.m_targets.push_back(ii);
+    }
+    m_decoders.push_back(dec);
+  } else {
+    std::size_t pos = 0;
+    while (pos < decoders.size()) {
+      std::size_t next = decoders.find(';', pos);
+      if (next == std::string::npos) {
+        next = decoders.size();
+      }
+      std::string entry = decoders.substr(pos, next - pos);
+      pos = next + 1;
+
+      hdm_decoder_s dec;
+      char* cur = const_cast<char*>(entry.c_str());
+      dec.m_base = std::strtoull(cur, &cur, 0);
+      ASSERTM(*cur == ':', "switch_hdm_decoders : base:size:gran:dev,dev,...\n");
+      dec.m_size = std::strtoull(cur + 1, &cur, 0);
+      ASSERTM(*cur == ':', "switch_hdm_decoders : base:size:gran:dev,dev,...\n");
+      dec.m_gran = std::strtoull(cur + 1, &cur, 0);
+      ASSERTM(*cur == ':', "switch_hdm_decoders : base:size:gran:dev,dev,...\n");
+      do {
+        dec.m_targets.push_back(static_cast<int>(std::strtol(cur + 1, &cur, 0)));
+      } while (*cur == ',');
+      dec.m_dpa_base = 0;
+      m_decoders.push_back(dec);
+    }
+  }
+
+  std::vector<Addr> next_dpa(m_num_dsp, 0);
+  for (auto& dec : m_decoders) {
+    Addr ways = dec.m_targets.size();
+    ASSERTM(dec.m_gran > 0 && (dec.m_gran & (dec.m_gran - 1)) == 0,
+            "hdm decoder granularity should be power of 2\n");
+    ASSERTM(dec.m_size % (dec.m_gran * ways) == 0,
+            "hdm decoder size should be a multiple of granularity * ways\n");
+
+    for (auto target : dec.m_targets) {
+      ASSERTM(target >= 0 && target < m_num_dsp, "hdm decoder target out of range\n");
+      dec.m_dpa_base = std::max(dec.m_dpa_base, next_dpa[target]);
+    }
+    for (auto target : dec.m_targets) {
+      next_dpa[target] = dec.m_dpa_base + dec.m_size / ways;
+    }
+  }
+}
+
+void cxl_switch_c::run_a_cycle(bool pll_locked) {
+  for (auto port : m_ports) {
+    port->run_a_cycle(pll_locked);
+  }
+  update_hol();
+
+  m_cycle++;
+}
+
+pcie_ep_c* cxl_switch_c::get_usp(int host) {
+  assert(host < m_num_usp);
+  return m_ports[host];
+}
+
+pcie_ep_c* cxl_switch_c::get_dsp(int dev) {
+  assert(dev < m_num_dsp);
+  return m_ports[m_num_usp + dev];
+}
+
+int cxl_switch_c::pending_size() {
+  int size = 0;
+  for (auto& buff : m_ingress) {
+    size += (int)buff.size();
+  }
+  return size;
+}
+
+// requests are interleaved over the targets of the decoder covering them,
+// the chunks of a target are packed in its device address space
+int cxl_switch_c::route(cxl_req_s* req, bool resp) {
+  if (resp) {
+    return req->m_host;
+  }
+
+  for (auto& dec : m_decoders) {
+    if (req->m_addr < dec.m_base) {
+      continue;
+    }
+    Addr offset = req->m_addr - dec.m_base;
+    if (dec.m_size && offset >= dec.m_size) {
+      continue;
+    }
+
+    Addr ways = dec.m_targets.size();
+    Addr chunk = offset / dec.m_gran;
+    req->m_dpa = dec.m_dpa_base + (chunk / ways) * dec.m_gran + offset % dec.m_gran;
+    return m_num_usp + dec.m_targets[chunk % ways];
+  }
+
+  ASSERTM(0, "address not covered by any hdm decoder\n");
+  return -1;
+}
+
+// writes carry data downstream, reads carry data upstream
+// - the flits arrive at the rate of the link into the ingress port
+Counter cxl_switch_c::get_overlap(int port, cxl_req_s* req, bool resp) {
+  if (req->m_write == resp) {
+    return 0;
+  }
+  int flits = (1 + m_data_slots + m_slots_per_flit - 1) / m_slots_per_flit;
+  return (flits - 1) * m_ports[port]->get_rx_flit_cycles();
+}
+
+void cxl_switch_c::ingress(int port, std::function<cxl_req_s*(void)> pull) {
+  std::list<switch_entry_s>& buff = m_ingress[port];
+  bool resp = (port >= m_num_usp);
+
+  while ((int)buff.size() < m_ingress_cap) {
+    cxl_req_s* req = pull();
+    if (req == NULL) {
+      return;
+    }
+
+    Counter latency = m_latency;
+    if (m_cut_through) {
+      latency -= std::min(latency, get_overlap(port, req, resp));
+    }
+
+    req->m_trace_cycle = m_cycle;
+    buff.push_back(switch_entry_s{req, route(req, resp), m_cycle, m_cycle + latency});
+  }
+
+  STAT_EVENT(SWITCH_INGRESS_FULL);
+  m_port_stats[port].m_ingress_full++;
+}
+
+void cxl_switch_c::egress(int port, std::function<bool(cxl_req_s*)> push) {
+  int cnt = 0;
+  while (cnt < CFG(KNOB_PCIE_TXVC_BW)) {
+    int winner = arbitrate(port);
+    if (winner < 0) {
+      break;
+    }
+
+    switch_entry_s& entry = m_ingress[winner].front();
+    if (!push(entry.m_req)) {
+      break;
+    }
+
+    Counter latency = m_cycle - entry.m_insert_cycle;
+    STAT_EVENT(SWITCH_FWD_BASE);
+    STAT_EVENT_N(AVG_SWITCH_LATENCY, latency);
+    m_port_stats[winner].m_fwd++;
+    m_port_stats[winner].m_latency += latency;
+
+    m_ingress[winner].pop_front();
+    m_last_grant[port] = winner;
+    ++cnt;
+  }
+}
+
+// only the head of an ingress buffer can compete : a head waiting for a
+// busy egress port blocks the entries behind it
+int cxl_switch_c::arbitrate(int port) {
+  int winner = -1;
+  int contenders = 0;
+
+  for (int ii = 0; ii < m_num_ports; ++ii) {
+    int in = (m_arb == SWITCH_ARB_RR) ? (m_last_grant[port] + 1 + ii) % m_num_ports : ii;
+    if (m_ingress[in].empty()) {
+      continue;
+    }
+
+    const switch_entry_s& head = m_ingress[in].front();
+    if (head.m_egress != port || head.m_ready_cycle > m_cycle) {
+      continue;
+    }
+
+    ++contenders;
+    if (winner == -1 || (m_arb == SWITCH_ARB_AGE && 
+          head.m_insert_cycle < m_ingress[winner].front().m_insert_cycle)) {
+      winner = in;
+    }
+  }
+
+  if (contenders > 1) {
+    STAT_EVENT(SWITCH_ARB_CONFLICT);
+  }
+  return winner;
+}
+
+void cxl_switch_c::update_hol() {
+  for (int ii = 0; ii < m_num_ports; ++ii) {
+    std::list<switch_entry_s>& buff = m_ingress[ii];
+    if (buff.empty() || buff.front().m_ready_cycle > m_cycle) {
+      continue;
+    }
+
+    int egress = buff.front().m_egress;
+    for (auto& entry : buff) {
+      if (entry.m_egress != egress) {
+        STAT_EVENT(SWITCH_HOL_BLOCKED);
+        m_port_stats[ii].m_hol_blocked++;
+        break;
+      }
+    }
+  }
+}
+
+void cxl_switch_c::finalize() {
+  std::ofstream* stream = m_simBase->get_output_stream("switch.stat.out");
+  if (stream == NULL) {
+    return;
+  }
+
+  std::ofstream& out = *stream;
+  double freq = CFG(KNOB_CLOCK_IO);
+  double cycles = m_cycle ? static_cast<double>(m_cycle) : 1.0;
+  out << "port,type,fwd,avg_latency,hol_blocked,ingress_full,tx_gbps" << std::endl;
+  for (int ii = 0; ii < m_num_ports; ++ii) {
+    switch_port_stat_s& stat = m_port_stats[ii];
+    out << std::fixed << std::setprecision(2) << ii << ","
+        << (ii < m_num_usp ? "usp" : "dsp") << ","
+        << stat.m_fwd << ","
+        << (stat.m_fwd ? 1.0 * stat.m_latency / stat.m_fwd : 0.0) << ","
+        << stat.m_hol_blocked << "," << stat.m_ingress_full << ","
+        << m_ports[ii]->m_txphys_bits * freq / cycles << std::endl;
+  }
+}
+
+void cxl_switch_c::checkpoint(checkpoint_c* ckpt) {
+  for (auto port : m_ports) {
+    port->checkpoint(ckpt);
+  }
+
+  for (auto& buff : m_ingress) {
+    uint64_t size = buff.size();
+    ckpt->io(size);
+    if (!ckpt->saving()) {
+      buff.resize(size);
+    }
+    for (auto& entry : buff) {
+      ckpt->io(entry.m_req);
+      ckpt->io(entry.m_egress);
+      ckpt->io(entry.m_insert_cycle);
+      ckpt->io(entry.m_ready_cycle);
+    }
+  }
+  ckpt->io(m_last_grant);
+  ckpt->io(m_port_stats);
+  ckpt->io(m_cycle);
+}
+
+void cxl_switch_c::print_switch_info() {
+  std::cout << "-------------- switch ------------------" << std::endl;
+  for (int ii = 0; ii < m_num_ports; ++ii) {
+    std::cout << (ii < m_num_usp ? "usp " : "dsp ") << ii << " ingress : ";
+    for (auto& entry : m_ingress[ii]) {
+      std::cout << entry.m_req->m_addr << "->" << entry.m_egress << " ; ";
+    }
+    std::cout << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+switch_port_c::switch_port_c(cxlsim_c* simBase, cxl_switch_c* sw, int port)
+  : pcie_ep_c(simBase), m_switch(sw), m_port(port) {
+}
+
+// same stage order as the mxp ports
+void switch_port_c::run_a_cycle(bool) {
+  process_txphys();
+  process_txdll();
+  process_txtrans();
+  start_transaction();
+
+  end_transaction();
+  process_rxtrans();
+  process_rxdll();
+  process_rxphys();
+
+  m_cycle++;
+}
+
+void switch_port_c::start_transaction() {
+  m_switch->egress(m_port, [this](cxl_req_s* req) { return push_txvc(req); });
+}
+
+void switch_port_c::end_transaction() {
+  m_switch->ingress(m_port, [this]() { return pull_rxvc(); });
+}
+
+void switch_port_c::trace_queue(cxl_req_s* req, Counter end) {
+  m_simBase->m_trace->req_span(req, "switch", req->m_trace_cycle, end);
+}
+
+} // namespace CXL
@@ -0,0 +1,242 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : cxl_switch.h
+ * Description  : CXL switch between the root complexes and the memory expanders
+ *********************************************************************************************/
+
+#ifndef CXL_SWITCH_H
+#define CXL_SWITCH_H
+
+#include <list>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "pcie_endpoint.h"
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+// arbitration among the ingress ports competing for an egress port
+typedef enum SWITCH_ARB_TYPE {
+  SWITCH_ARB_RR = 0, /**< round robin from the last granted port */
+  SWITCH_ARB_AGE,    /**< oldest head first */
+  SWITCH_ARB_FIXED,  /**< lowest port first */
+  MAX_SWITCH_ARB_TYPES
+} SWITCH_ARB_TYPE;
+
+static const std::string switch_arb_string[MAX_SWITCH_ARB_TYPES] = {
+  "rr",
+  "age",
+  "fixed"
+};
+
+// hdm decoder : a host address range interleaved over downstream ports
+typedef struct hdm_decoder_s {
+  Addr m_base; /**< first host address */
+  Addr m_size; /**< bytes covered (0 : up to the end of the address space) */
+  Addr m_gran; /**< interleave granularity in bytes */
+  Addr m_dpa_base; /**< device address of the range on each target */
+  std::vector<int> m_targets; /**< devices in interleave order */
+} hdm_decoder_s;
+
+// ingress buffer entry
+typedef struct switch_entry_s {
+  cxl_req_s* m_req; /**< request (or its response) */
+  int m_egress; /**< port to forward to */
+  Counter m_insert_cycle; /**< cycle the message left the ingress link */
+  Counter m_ready_cycle; /**< earliest cycle it may leave the egress port */
+} switch_entry_s;
+
+// per port counters (switch.stat.out)
+typedef struct switch_port_stat_s {
+  Counter m_fwd; /**< messages forwarded from this ingress */
+  Counter m_latency; /**< cycles those messages spent in the switch */
+  Counter m_hol_blocked; /**< cycles the head blocked entries for other ports */
+  Counter m_ingress_full; /**< cycles the ingress buffer was full */
+} switch_port_stat_s;
+
+class switch_port_c;
+
+// ports 0 .. num_hosts - 1 are upstream (linked to the root complexes), the
+// rest are downstream (linked to the mxps). requests are routed by the hdm
+// decoders, responses by the host that issued them
+class cxl_switch_c
+{
+  friend class switch_port_c;
+
+public:
+  /**
+   * Constructor
+   */
+  cxl_switch_c(cxlsim_c* simBase);
+
+  /**
+   * Destructor
+   */
+  ~cxl_switch_c();
+
+  /**
+   * Tick a cycle
+   */
+  void run_a_cycle(bool pll_locked);
+
+  /**
+   * Upstream port linked to the root complex of a host
+   */
+  pcie_ep_c* get_usp(int host);
+
+  /**
+   * Downstream port linked to a memory expander
+   */
+  pcie_ep_c* get_dsp(int dev);
+
+  /**
+   * Number of messages buffered in the switch
+   */
+  int pending_size();
+
+  /**
+   * Dump the per port stats
+   */
+  void finalize();
+
+  /**
+   * Save or restore the state
+   */
+  void checkpoint(checkpoint_c* ckpt);
+
+  /**
+   * Print for debugging
+   */
+  void print_switch_info();
+
+private:
+  cxl_switch_c(); // do not implement
+
+  /**
+   * Build the hdm decoders from switch_hdm_decoders
+   */
+  void init_decoders();
+
+  /**
+   * Egress port of a request (hdm decoders) or a response (host), also sets
+   * the device physical address of requests
+   */
+  int route(cxl_req_s* req, bool resp);
+
+  /**
+   * Cycles the tail of a message arrives after its header flit
+   */
+  Counter get_overlap(int port, cxl_req_s* req, bool resp);
+
+  /**
+   * Move messages from the rx vc of a port into its ingress buffer
+   */
+  void ingress(int port, std::function<cxl_req_s*(void)> pull);
+
+  /**
+   * Forward the heads of the ingress buffers to the tx vc of a port
+   */
+  void egress(int port, std::function<bool(cxl_req_s*)> push);
+
+  /**
+   * Ingress port whose head wins the egress port (-1 : none)
+   */
+  int arbitrate(int port);
+
+  /**
+   * Count ingress ports whose ready head holds back entries for other ports
+   */
+  void update_hol();
+
+private:
+  cxlsim_c* m_simBase; /**< simulation base */
+  int m_num_usp; /**< upstream ports (one per host) */
+  int m_num_dsp; /**< downstream ports (one per mxp) */
+  int m_num_ports; /**< all ports */
+  std::vector<switch_port_c*> m_ports; /**< usps first, then dsps */
+
+  int m_ingress_cap; /**< ingress buffer capacity of each port */
+  std::vector<std::list<switch_entry_s>> m_ingress; /**< ingress buffers */
+
+  Counter m_latency; /**< port to port latency */
+  bool m_cut_through; /**< forward before the tail of a message is in */
+  int m_data_slots; /**< data slots of a cacheline */
+  int m_slots_per_flit;
+
+  SWITCH_ARB_TYPE m_arb; /**< arbitration policy */
+  std::vector<int> m_last_grant; /**< last ingress granted, per egress */
+  std::vector<hdm_decoder_s> m_decoders; /**< routing table */
+  std::vector<switch_port_stat_s> m_port_stats;
+
+  Counter m_cycle; /**< switch clock (io) */
+};
+
+// switch port : pcie endpoint whose transaction layer is the switch
+class switch_port_c : public pcie_ep_c
+{
+public:
+  /**
+   * Constructor
+   */
+  switch_port_c(cxlsim_c* simBase, cxl_switch_c* sw, int port);
+
+  /**
+   * Tick a cycle
+   */
+  void run_a_cycle(bool pll_locked) override;
+
+private:
+  switch_port_c(); // do not implement
+
+  /**
+   * Forward messages buffered for this port
+   */
+  void start_transaction() override;
+
+  /**
+   * Move received messages into the ingress buffer
+   */
+  void end_transaction() override;
+
+  /**
+   * Time in the switch (trace)
+   */
+  void trace_queue(cxl_req_s* req, Counter end) override;
+
+private:
+  cxl_switch_c* m_switch; /**< switch */
+  int m_port; /**< port id in the switch */
+};
+
+} // namespace CXL
+#endif // CXL_SWITCH_H
@@ -35,16 +35,28 @@ POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************************************/
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <list>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/stat.h>
 
 #include "pcie_endpoint.h"
 #include "cxl_t3.h"
 #include "pcie_rc.h"
 #include "pcie_vcbuff.h"
 #include "cxlsim.h"
+#include "trace_event.h"
+#include "sim_profile.h"
+#include "checkpoint.h"
 
 #include "all_knobs.h"
+#include "all_stats.h"
 #include "statistics.h"
+#include "assert_macros.h"
 
 #include "ramulator/src/Request.h"
 
@@ -57,19 +69,122 @@ cxlt3_c::cxlt3_c(cxlsim_c* simBase)
     m_read_cb_func(
       std::bind(&cxlt3_c::readComplete, this, std::placeholders::_1)),
     m_write_cb_func(std::bind(&cxlt3_c::writeComplete, this,
+                            std::placeholders::_1)),
+    m_wbuff_cb_func(std::bind(&cxlt3_c::wbuffComplete, this,
+                            std::placeholders::_1)),
+    m_pref_cb_func(std::bind(&cxlt3_c::prefComplete, this,
                             std::placeholders::_1)) {
+  // init logical devices
+  m_num_ld = CFG(KNOB_NUM_HOSTS);
+  m_ld_size_bits = CFG(KNOB_MXP_LD_SIZE_BITS);
+  m_ld_vtime.resize(m_num_ld, 0.0);
+  m_vtime = 0.0;
+  m_ld_weight.resize(m_num_ld, 1);
+
+  std::string weights = *KNOB(KNOB_MXP_LD_WEIGHTS);
+  std::size_t pos = 0;
+  for (int ii = 0; ii < m_num_ld && pos < weights.size(); ++ii) {
+    std::size_t next = weights.find(',', pos);
+    if (next == std::string::npos) {
+      next = weights.size();
+    }
+    m_ld_weight[ii] = std::atoi(weights.substr(pos, next - pos).c_str());
+    ASSERTM(m_ld_weight[ii] > 0, "mxp_ld_weights should be positive\n");
+    pos = next + 1;
+  }
+
+  // behind a switch, the LDs share the link to the downstream port
+  m_shared_link = CFG(KNOB_SWITCH_ENABLE);
+  m_resp_ld = 0;
+  m_ports.push_back(this);
+  for (int ii = 1; ii < m_num_ld && !m_shared_link; ++ii) {
+    m_ports.push_back(new mxp_port_c(simBase, this, ii));
+  }
+
   // init queues
-  m_pending_req = new list<cxl_req_s*>();
-  m_pending_cap = *KNOB(KNOB_MXP_RAMU_PEND_CAP);
+  m_pending_req = new list<cxl_req_s*>[m_num_ld];
+  m_mxp_resp_queue = new list<cxl_req_s*>[m_num_ld];
+  m_pending_cap = CFG(KNOB_MXP_RAMU_PEND_CAP);
+
+  // init devload
+  m_devload_thresh[DEVLOAD_LIGHT] = 0;
+  m_devload_thresh[DEVLOAD_OPTIMAL] = CFG(KNOB_MXP_DEVLOAD_OPTIMAL);
+  m_devload_thresh[DEVLOAD_MODERATE] = CFG(KNOB_MXP_DEVLOAD_MODERATE);
+  m_devload_thresh[DEVLOAD_SEVERE] = CFG(KNOB_MXP_DEVLOAD_SEVERE);
+  m_devload_dram_cap = CFG(KNOB_MXP_DEVLOAD_DRAM_CAP);
+
+  ASSERTM(m_pending_cap > 0, "ramu_pendq_capacity should be positive\n");
+  ASSERTM(m_devload_dram_cap > 0, "mxp_devload_dram_cap should be positive\n");
+  ASSERTM(m_devload_thresh[DEVLOAD_OPTIMAL] <= m_devload_thresh[DEVLOAD_MODERATE] &&
+          m_devload_thresh[DEVLOAD_MODERATE] <= m_devload_thresh[DEVLOAD_SEVERE],
+          "devload thresholds should be optimal <= moderate <= severe\n");
+
+  // init write buffer
+  m_wbuff_enable = CFG(KNOB_MXP_WBUFF_ENABLE);
+  m_wbuff_drain = false;
+  m_wbuff_cap = CFG(KNOB_MXP_WBUFF_CAPACITY);
+  m_wbuff_hwm = CFG(KNOB_MXP_WBUFF_HIGH_WATERMARK);
+  m_wbuff_lwm = CFG(KNOB_MXP_WBUFF_LOW_WATERMARK);
+  m_wbuff_uid = 0;
+
+  ASSERTM(m_wbuff_lwm <= m_wbuff_hwm && m_wbuff_hwm <= m_wbuff_cap,
+          "write buffer watermarks should be low <= high <= capacity\n");
+
+  // init prefetcher
+  m_pref = new mxp_prefetcher_c(simBase);
+  m_pref_buff_cap = CFG(KNOB_MXP_PREF_BUFF_CAPACITY);
+  m_pref_queue_cap = CFG(KNOB_MXP_PREF_QUEUE_CAPACITY);
+  m_pref_throttle = CFG(KNOB_MXP_PREF_DRAM_THROTTLE);
+  m_pref_uid = 0;
+
+  // init dram energy
+  // - the command trace of each mxp is written to the stat directory and
+  //   removed once counted
+  m_dram_energy_enable = CFG(KNOB_DRAM_ENERGY_ENABLE);
+  m_dram_cmd_energy[DRAM_CMD_ACT] = CFG(KNOB_DRAM_ACT_ENERGY);
+  m_dram_cmd_energy[DRAM_CMD_RD] = CFG(KNOB_DRAM_RD_ENERGY);
+  m_dram_cmd_energy[DRAM_CMD_WR] = CFG(KNOB_DRAM_WR_ENERGY);
+  m_dram_cmd_energy[DRAM_CMD_REF] = CFG(KNOB_DRAM_REF_ENERGY);
+  std::fill_n(m_dram_cmds, MAX_DRAM_CMD_TYPES, 0);
+
+  std::string stat_path = *KNOB(KNOB_STATISTICS_OUT_DIRECTORY);
+  std::string cmd_trace;
+  if (m_dram_energy_enable) {
+    mkdir(stat_path.c_str(), S_IRWXU);
+    cmd_trace = stat_path + "/mxp" + std::to_string(simBase->m_mxps.size()) + ".cmd-";
+  }
 
   // init ramulator
+  // - Config::add keeps a value the file already set : with dram energy the
+  //   command trace options are dropped from a copy of the file, so that the
+  //   wrapper turns the trace on
   std::string config_file(*KNOB(KNOB_RAMULATOR_CONFIG_FILE));
-  configs.parse(config_file);
-  configs.set_core_num(*KNOB(KNOB_NUM_SIM_CORES));
+  if (m_dram_energy_enable) {
+    std::ifstream in(config_file);
+    ASSERTM(in.is_open(), "cannot read ramulator_config_file\n");
+    std::string filtered = cmd_trace + "cfg";
+    std::ofstream out(filtered);
+    std::string line;
+    while (std::getline(in, line)) {
+      std::istringstream tokens(line);
+      std::string key;
+      tokens >> key;
+      key = key.substr(0, key.find('='));
+      if (key == "record_cmd_trace" || key == "cmd_trace_prefix") {
+        continue;
+      }
+      out << line << std::endl;
+    }
+    out.close();
+    configs.parse(filtered);
+    std::remove(filtered.c_str());
+  } else {
+    configs.parse(config_file);
+  }
+  configs.set_core_num(CFG(KNOB_NUM_SIM_CORES));
 
   m_ramu_wrapper = new ramulator::CXLRamulatorWrapper(
-    configs, *KNOB(KNOB_RAMULATOR_CACHELINE_SIZE),
-    *KNOB(KNOB_STATISTICS_OUT_DIRECTORY));
+    configs, CFG(KNOB_RAMULATOR_CACHELINE_SIZE), stat_path, cmd_trace);
 
   // init others
   m_cycle_internal = 0;
@@ -78,7 +193,20 @@ cxlt3_c::cxlt3_c(cxlsim_c* simBase)
 cxlt3_c::~cxlt3_c() {
   m_ramu_wrapper->finish();
   delete m_ramu_wrapper;
-  delete m_pending_req;
+  delete[] m_pending_req;
+  delete[] m_mxp_resp_queue;
+  for (int ii = 1; ii < (int)m_ports.size(); ++ii) {
+    delete m_ports[ii];
+  }
+
+  for (auto entry : m_wbuff) {
+    delete entry;
+  }
+
+  for (auto line : m_pref_lines) {
+    delete line;
+  }
+  delete m_pref;
 }
 
 void cxlt3_c::run_a_cycle(bool pll_locked) {
@@ -97,61 +225,300 @@ void cxlt3_c::run_a_cycle(bool pll_locked) {
   process_rxdll();
   process_rxphys();
 
+  // links to the other hosts
+  for (int ii = 1; ii < (int)m_ports.size(); ++ii) {
+    m_ports[ii]->run_a_cycle(pll_locked);
+  }
+
   m_cycle++;
 }
 
 void cxlt3_c::run_a_cycle_internal(bool pll_locked) {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_RAMULATOR);
   m_ramu_wrapper->tick();
   m_cycle_internal++;
 }
 
+int cxlt3_c::pending_size() {
+  int size = 0;
+  for (int ii = 0; ii < m_num_ld; ++ii) {
+    size += (int)m_pending_req[ii].size();
+  }
+  return size;
+}
+
+int cxlt3_c::num_ld() {
+  return m_num_ld;
+}
+
+pcie_ep_c* cxlt3_c::get_port(int ld) {
+  assert(ld < (int)m_ports.size());
+  return m_ports[ld];
+}
+
+int cxlt3_c::dram_pending_size() {
+  return m_ramu_wrapper->pending_requests();
+}
+
+bool cxlt3_c::dram_idle() {
+  return m_mxp_requestsInFlight == 0;
+}
+
+// ramulator state is not part of the checkpoint : with the dram idle, no
+// request waits for a dram callback and a restored run starts from a
+// fresh dram (all banks closed)
+void cxlt3_c::checkpoint(checkpoint_c* ckpt) {
+  assert(dram_idle());
+  pcie_ep_c::checkpoint(ckpt);
+
+  for (int ii = 0; ii < m_num_ld; ++ii) {
+    ckpt->io(m_pending_req[ii]);
+    ckpt->io(m_mxp_resp_queue[ii]);
+  }
+  ckpt->io(m_ld_vtime);
+  ckpt->io(m_vtime);
+  ckpt->io(m_resp_ld);
+  ckpt->io(m_cycle_internal);
+
+  // write buffer : none of the lines is drained yet
+  ckpt->io(m_wbuff_drain);
+  ckpt->io(m_wbuff_uid);
+  uint64_t size = m_wbuff.size();
+  ckpt->io(size);
+  if (ckpt->saving()) {
+    for (auto entry : m_wbuff) {
+      assert(!entry->m_issued);
+      ckpt->io(*entry);
+    }
+  } else {
+    assert(m_wbuff.empty());
+    for (uint64_t ii = 0; ii < size; ++ii) {
+      wbuff_entry_s* entry = new wbuff_entry_s;
+      ckpt->io(*entry);
+      m_wbuff.push_back(entry);
+      m_wbuff_pending[entry->m_addr] = entry;
+    }
+  }
+
+  // prefetcher : all prefetched lines are ready, no demand waits for them
+  m_pref->checkpoint(ckpt);
+  ckpt->io(m_pref_uid);
+  ckpt->io(m_pref_queue);
+  size = m_pref_lines.size();
+  ckpt->io(size);
+  if (ckpt->saving()) {
+    for (auto line : m_pref_lines) {
+      assert(line->m_ready && line->m_waiting.empty());
+      ckpt->io(line->m_addr);
+      ckpt->io(line->m_valid);
+      ckpt->io(line->m_insert_cycle);
+    }
+  } else {
+    assert(m_pref_lines.empty());
+    for (uint64_t ii = 0; ii < size; ++ii) {
+      pref_line_s* line = new pref_line_s;
+      line->m_ready = true;
+      ckpt->io(line->m_addr);
+      ckpt->io(line->m_valid);
+      ckpt->io(line->m_insert_cycle);
+      m_pref_lines.push_back(line);
+      if (line->m_valid) {
+        m_pref_buff[line->m_addr] = line;
+      }
+    }
+  }
+
+  for (int ii = 1; ii < (int)m_ports.size(); ++ii) {
+    m_ports[ii]->checkpoint(ckpt);
+  }
+}
+
+// ramulator writes the commands while it runs : count them once it is closed
+void cxlt3_c::finalize() {
+  if (!m_dram_energy_enable) {
+    return;
+  }
+
+  std::map<std::string, long> counts;
+  m_ramu_wrapper->finish();
+  m_ramu_wrapper->count_commands(counts);
+  m_dram_cmds[DRAM_CMD_ACT] = counts["ACT"];
+  m_dram_cmds[DRAM_CMD_RD] = counts["RD"] + counts["RDA"];
+  m_dram_cmds[DRAM_CMD_WR] = counts["WR"] + counts["WRA"];
+  m_dram_cmds[DRAM_CMD_REF] = counts["REF"];
+}
+
+Counter cxlt3_c::get_dram_cmds(int type) {
+  return m_dram_cmds[type];
+}
+
+double cxlt3_c::get_dram_energy(int type) {
+  return m_dram_cmds[type] * m_dram_cmd_energy[type];
+}
+
+// mW over the simulated io cycles (/ clock_io ns) : pJ
+double cxlt3_c::get_dram_background_energy() {
+  if (!m_dram_energy_enable) {
+    return 0.0;
+  }
+  return CFG(KNOB_DRAM_BACKGROUND_POWER) * m_cycle / CFG(KNOB_CLOCK_IO);
+}
+
 // for requests finished from ramulator, send the response back to 
 // the root complex
 void cxlt3_c::start_transaction() {
+  auto push = [this](cxl_req_s* req) { return push_txvc(req); };
+  if (!m_shared_link) {
+    send_resp(0, CFG(KNOB_PCIE_TXVC_BW), push);
+    return;
+  }
+
+  // the LDs take turns to go first on the shared link
+  int budget = CFG(KNOB_PCIE_TXVC_BW);
+  for (int ii = 0; ii < m_num_ld && budget > 0; ++ii) {
+    budget -= send_resp((m_resp_ld + ii) % m_num_ld, budget, push);
+  }
+  m_resp_ld = (m_resp_ld + 1) % m_num_ld;
+}
+
+int cxlt3_c::send_resp(int ld, int budget, std::function<bool(cxl_req_s*)> push) {
   int cnt = 0;
-  vector<cxl_req_s*> tmp_list;
-  for (auto req : m_mxp_resp_queue) {
-    bool success = push_txvc(req);
-    if (success) {
-      tmp_list.push_back(req);
-      cnt++;
-    }
-    if (cnt == *KNOB(KNOB_PCIE_TXVC_BW) || !success) {
+  std::list<cxl_req_s*>& resp_queue = m_mxp_resp_queue[ld];
+  DEVLOAD_TYPE devload = get_devload(ld);
+  while (!resp_queue.empty()) {
+    cxl_req_s* req = resp_queue.front();
+    req->m_devload = devload;
+    if (!push(req)) {
+      break;
+    }
+
+    resp_queue.pop_front();
+    STAT_EVENT(MXP_DEVLOAD_LIGHT + devload);
+    STAT_EVENT(MXP_CTRL_MSGS);
+    if (++cnt == budget) {
       break;
     }
   }
+  return cnt;
+}
+
+void cxlt3_c::push_resp(cxl_req_s* req) {
+  m_mxp_resp_queue[req->m_host].push_back(req);
+}
 
-  for (auto I = tmp_list.begin(), end = tmp_list.end(); I != end; ++I) {
-    m_mxp_resp_queue.remove(*I);
+// devload is the worse of the request queue of the LD & dram occupancy
+DEVLOAD_TYPE cxlt3_c::get_devload(int ld) {
+  int pending = 100 * (int)m_pending_req[ld].size() / m_pending_cap;
+  int dram = 100 * m_ramu_wrapper->pending_requests() / m_devload_dram_cap;
+  int occupancy = std::max(pending, dram);
+
+  for (int ii = MAX_DEVLOAD_TYPES - 1; ii > 0; ii--) {
+    if (occupancy >= m_devload_thresh[ii]) {
+      return static_cast<DEVLOAD_TYPE>(ii);
+    }
   }
+  return DEVLOAD_LIGHT;
 }
 
 // transactions ends in the viewpoint of RC
 // read messages from the rx vc & insert them into the dram pending queue
 void cxlt3_c::end_transaction() {
-  while (m_pending_cap > (int)m_pending_req->size()) {
-    cxl_req_s* req = pull_rxvc();
+  recv_req(m_shared_link ? -1 : 0, [this]() { return pull_rxvc(); });
+}
+
+// a shared link stops only when the pending queues are full altogether as
+// the LD of the next request is unknown before pulling it
+void cxlt3_c::recv_req(int ld, std::function<cxl_req_s*(void)> pull) {
+  while (ld < 0 ? pending_size() < m_pending_cap * m_num_ld 
+                : (int)m_pending_req[ld].size() < m_pending_cap) {
+    cxl_req_s* req = pull();
     if (req == NULL) {
       break;
-    } else {
-      m_pending_req->push_back(req);
+    }
+
+    int req_ld = ld < 0 ? req->m_host : ld;
+    req->m_trace_cycle = m_cycle;
+    STAT_EVENT(MXP_CTRL_MSGS);
+    req->m_dpa = get_dpa(req->m_dpa, req_ld);
+    if (!access_pref_buff(req)) {
+      if (m_pending_req[req_ld].empty()) {
+        activate_ld(req_ld);
+      }
+      m_pending_req[req_ld].push_back(req);
     }
   }
 }
 
+// each LD owns a 2^ld_size_bits range of the dram
+// - a single LD uses the address as it is
+Addr cxlt3_c::get_dpa(Addr addr, int ld) {
+  if (m_num_ld == 1) {
+    return addr;
+  }
+  Addr mask = (static_cast<Addr>(1) << m_ld_size_bits) - 1;
+  return (static_cast<Addr>(ld) << m_ld_size_bits) | (addr & mask);
+}
+
+// weighted fair sharing of the dram queue : the LD with the least virtual
+// time (issued requests per weight) gets the first chance every cycle
+void cxlt3_c::get_ld_order(std::vector<int>& order) {
+  order.clear();
+  for (int ii = 0; ii < m_num_ld; ++ii) {
+    order.push_back(ii);
+  }
+  if (m_num_ld == 1) {
+    return;
+  }
+
+  std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+    return m_ld_vtime[a] < m_ld_vtime[b];
+  });
+}
+
+// an idle LD does not bank service : it restarts at the minimum virtual
+// time of the busy LDs (or of the last issue when none is busy), otherwise
+// it would starve them until it caught up
+void cxlt3_c::activate_ld(int ld) {
+  bool busy = false;
+  double vtime = m_vtime;
+  for (int ii = 0; ii < m_num_ld; ++ii) {
+    if (ii == ld || m_pending_req[ii].empty()) {
+      continue;
+    }
+    vtime = busy ? std::min(vtime, m_ld_vtime[ii]) : m_ld_vtime[ii];
+    busy = true;
+  }
+  m_ld_vtime[ld] = std::max(m_ld_vtime[ld], vtime);
+}
+
+void cxlt3_c::serve_ld(int ld) {
+  m_vtime = std::max(m_vtime, m_ld_vtime[ld]);
+  m_ld_vtime[ld] += 1.0 / m_ld_weight[ld];
+}
+
 // insert requests in to the ramulator
 void cxlt3_c::process_pending_req() {
-  std::vector<cxl_req_s*> tmp_list;
-  for (auto I = m_pending_req->begin(); I != m_pending_req->end(); I++) {
-    cxl_req_s* req = *I;
-    if (push_ramu_req(req)) {
-      tmp_list.push_back(req);
-    }
+  if (m_wbuff_enable) {
+    process_pending_req_wbuff();
+    issue_pref();
+    return;
   }
 
-  for (auto I = tmp_list.begin(), end = tmp_list.end(); I != end; ++I) {
-    m_pending_req->remove(*I);
+  std::vector<int> order;
+  get_ld_order(order);
+  for (int ld : order) {
+    std::list<cxl_req_s*>& pending = m_pending_req[ld];
+    for (auto I = pending.begin(); I != pending.end(); ) {
+      if (push_ramu_req(*I)) {
+        serve_ld(ld);
+        I = pending.erase(I);
+      } else {
+        ++I;
+      }
+    }
   }
+
+  issue_pref();
 }
 
 bool cxlt3_c::push_ramu_req(cxl_req_s* req) {
@@ -159,12 +526,18 @@ bool cxlt3_c::push_ramu_req(cxl_req_s* req) {
   auto req_type = (is_write) ? ramulator::Request::Type::WRITE
                              : ramulator::Request::Type::READ;
   auto cb_func = (is_write) ? m_write_cb_func : m_read_cb_func;
-  long addr = static_cast<long>(req->m_addr);
+  long addr = static_cast<long>(req->m_dpa);
 
   ramulator::Request ramu_req(addr, req_type, cb_func, req->m_id,0);
   bool accepted = m_ramu_wrapper->send(ramu_req);
 
   if (accepted) {
+    if (req->m_traced) {
+      m_simBase->m_trace->req_span(req, "dev pending", req->m_trace_cycle, 
+                                   m_cycle);
+      req->m_trace_cycle = m_cycle;
+    }
+
     if (is_write) {
       m_mxp_writes[ramu_req.reqid] = req;
     } else {
@@ -175,26 +548,298 @@ bool cxlt3_c::push_ramu_req(cxl_req_s* req) {
   return accepted;
 }
 
+// insert requests in to the ramulator through the write buffer
+// - writes are acknowledged as soon as they are buffered
+// - reads that hit a buffered line are served by the buffer
+// - reads have priority over writes unless the buffer is in drain mode
+void cxlt3_c::process_pending_req_wbuff() {
+  bool reads_pending = false;
+  std::vector<int> order;
+  get_ld_order(order);
+  for (int ld : order) {
+    // lines of older writes still waiting for a buffer entry : a read of
+    // one of them may neither be forwarded nor go to the dram yet
+    std::set<Addr> blocked;
+    std::list<cxl_req_s*>& pending = m_pending_req[ld];
+    for (auto I = pending.begin(); I != pending.end(); ) {
+      cxl_req_s* req = *I;
+      bool done = false;
+      if (req->m_write) {
+        if (insert_wbuff(req)) {
+          done = true;
+          push_resp(req);
+        } else {
+          blocked.insert(get_line_addr(req->m_dpa));
+        }
+      } else if (blocked.find(get_line_addr(req->m_dpa)) != blocked.end()) {
+        // waits for the write, which needs the buffer drained
+      } else if (wbuff_hit(req->m_dpa)) {
+        STAT_EVENT(MXP_WBUFF_FORWARD);
+        done = true;
+        push_resp(req);
+      } else if (!m_wbuff_drain && push_ramu_req(req)) {
+        done = true;
+      } else {
+        reads_pending = true;
+      }
+
+      if (done) {
+        serve_ld(ld);
+        I = pending.erase(I);
+      } else {
+        ++I;
+      }
+    }
+  }
+
+  drain_wbuff(reads_pending);
+}
+
+bool cxlt3_c::insert_wbuff(cxl_req_s* req) {
+  Addr line = get_line_addr(req->m_dpa);
+
+  // merge into a line that is not drained yet
+  auto iter = m_wbuff_pending.find(line);
+  if (iter != m_wbuff_pending.end()) {
+    iter->second->m_merged++;
+    STAT_EVENT(MXP_WBUFF_MERGE);
+    return true;
+  }
+
+  if ((int)m_wbuff.size() >= m_wbuff_cap) {
+    return false;
+  }
+
+  wbuff_entry_s* entry = new wbuff_entry_s;
+  entry->m_addr = line;
+  entry->m_merged = 0;
+  entry->m_issued = false;
+  entry->m_insert_cycle = m_cycle;
+
+  m_wbuff.push_back(entry);
+  m_wbuff_pending[line] = entry;
+  STAT_EVENT(MXP_WBUFF_INSERT);
+  return true;
+}
+
+bool cxlt3_c::wbuff_hit(Addr addr) {
+  Addr line = get_line_addr(addr);
+  if (m_wbuff_pending.find(line) != m_wbuff_pending.end()) {
+    return true;
+  }
+
+  // the data stays in the buffer until the dram write completes
+  for (const auto& x : m_wbuff_inflight) {
+    if (x.second->m_addr == line) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void cxlt3_c::drain_wbuff(bool reads_pending) {
+  int occupancy = (int)m_wbuff_pending.size();
+  if (!m_wbuff_drain && occupancy >= m_wbuff_hwm) {
+    m_wbuff_drain = true;
+    STAT_EVENT(MXP_WBUFF_DRAIN);
+  } else if (m_wbuff_drain && occupancy <= m_wbuff_lwm) {
+    m_wbuff_drain = false;
+  }
+
+  // read priority mode : write only when there are no reads waiting
+  if (!m_wbuff_drain && reads_pending) {
+    return;
+  }
+
+  for (auto entry : m_wbuff) {
+    if (entry->m_issued) {
+      continue;
+    }
+
+    long addr = static_cast<long>(entry->m_addr);
+    ramulator::Request ramu_req(addr, ramulator::Request::Type::WRITE,
+                                m_wbuff_cb_func, ++m_wbuff_uid, 0);
+    if (!m_ramu_wrapper->send(ramu_req)) {
+      break;
+    }
+
+    entry->m_issued = true;
+    m_wbuff_pending.erase(entry->m_addr);
+    m_wbuff_inflight[m_wbuff_uid] = entry;
+    ++m_mxp_requestsInFlight;
+    STAT_EVENT(MXP_WBUFF_DRAIN_WRITE);
+
+    if (m_wbuff_drain && (int)m_wbuff_pending.size() <= m_wbuff_lwm) {
+      m_wbuff_drain = false;
+      break;
+    }
+  }
+}
+
+Addr cxlt3_c::get_line_addr(Addr addr) {
+  Addr line_size = CFG(KNOB_RAMULATOR_CACHELINE_SIZE);
+  return addr - (addr % line_size);
+}
+
+bool cxlt3_c::access_pref_buff(cxl_req_s* req) {
+  if (!m_pref->enabled()) {
+    return false;
+  }
+
+  Addr line = get_line_addr(req->m_dpa);
+  auto iter = m_pref_buff.find(line);
+
+  // writes make the prefetched copy stale
+  if (req->m_write) {
+    if (iter != m_pref_buff.end()) {
+      pref_line_s* pref_line = iter->second;
+      m_pref_buff.erase(iter);
+      if (pref_line->m_ready) {
+        m_pref_lines.remove(pref_line);
+        delete pref_line;
+      } else {
+        pref_line->m_valid = false;
+      }
+    }
+    return false;
+  }
+
+  STAT_EVENT(MXP_PREF_DEMAND);
+
+  if (iter != m_pref_buff.end()) {
+    pref_line_s* pref_line = iter->second;
+    STAT_EVENT(MXP_PREF_ACCURACY);
+    STAT_EVENT(MXP_PREF_COVERAGE);
+
+    if (pref_line->m_ready) {
+      STAT_EVENT(MXP_PREF_HIT);
+      m_pref_buff.erase(iter);
+      m_pref_lines.remove(pref_line);
+      delete pref_line;
+      push_resp(req);
+    } else {
+      // prefetch is still in the dram : wait for it
+      STAT_EVENT(MXP_PREF_LATE);
+      m_pref_buff.erase(iter);
+      pref_line->m_waiting.push_back(req);
+    }
+    return true;
+  }
+
+  std::list<Addr> cand;
+  m_pref->train(line, cand);
+  for (auto addr : cand) {
+    if ((int)m_pref_queue.size() >= m_pref_queue_cap) {
+      m_pref_queue.pop_front();
+    }
+    m_pref_queue.push_back(addr);
+  }
+  return false;
+}
+
+void cxlt3_c::issue_pref() {
+  if (m_pref_queue.empty()) {
+    return;
+  }
+
+  // demand reads have priority
+  // - a line with an outstanding write (queued or in the dram) is not
+  //   prefetched, the prefetch could read the data before the write
+  std::set<Addr> written;
+  for (int ii = 0; ii < m_num_ld; ++ii) {
+    for (auto req : m_pending_req[ii]) {
+      if (!req->m_write) {
+        return;
+      }
+      written.insert(get_line_addr(req->m_dpa));
+    }
+  }
+  for (const auto& x : m_mxp_writes) {
+    written.insert(get_line_addr(x.second->m_dpa));
+  }
+
+  while (!m_pref_queue.empty()) {
+    if (m_ramu_wrapper->pending_requests() >= m_pref_throttle) {
+      STAT_EVENT(MXP_PREF_THROTTLE);
+      break;
+    }
+
+    Addr line = m_pref_queue.front();
+    if (m_pref_buff.find(line) != m_pref_buff.end() ||
+        written.find(line) != written.end() ||
+        (m_wbuff_enable && wbuff_hit(line))) {
+      m_pref_queue.pop_front();
+      continue;
+    }
+
+    if ((int)m_pref_lines.size() >= m_pref_buff_cap && !evict_pref()) {
+      break;
+    }
+
+    ramulator::Request ramu_req(static_cast<long>(line),
+                                ramulator::Request::Type::READ,
+                                m_pref_cb_func, ++m_pref_uid, 0);
+    if (!m_ramu_wrapper->send(ramu_req)) {
+      break;
+    }
+
+    pref_line_s* pref_line = new pref_line_s;
+    pref_line->m_addr = line;
+    pref_line->m_ready = false;
+    pref_line->m_valid = true;
+    pref_line->m_insert_cycle = m_cycle;
+
+    m_pref_lines.push_back(pref_line);
+    m_pref_buff[line] = pref_line;
+    m_pref_inflight[m_pref_uid] = pref_line;
+    m_pref_queue.pop_front();
+    ++m_mxp_requestsInFlight;
+    STAT_EVENT(MXP_PREF_ISSUE);
+  }
+}
+
+bool cxlt3_c::evict_pref() {
+  for (auto pref_line : m_pref_lines) {
+    if (!pref_line->m_ready) {
+      continue;
+    }
+
+    if (pref_line->m_valid) {
+      m_pref_buff.erase(pref_line->m_addr);
+      STAT_EVENT(MXP_PREF_EVICT_UNUSED);
+    }
+    m_pref_lines.remove(pref_line);
+    delete pref_line;
+    return true;
+  }
+  return false;
+}
+
 // ramulator read callback
 void cxlt3_c::readComplete(ramulator::Request &ramu_req) {
-  if (*KNOB(KNOB_DEBUG_CALLBACK)) {
+  if (CFG(KNOB_DEBUG_CALLBACK)) {
     printf("CXL RAM read callback done: 0x%lu\n", ramu_req.reqid);
   }
 
   assert(m_mxp_reads.find(ramu_req.reqid) != m_mxp_reads.end());
 
-  auto &cxl_req = m_mxp_reads[ramu_req.reqid];
+  cxl_req_s* cxl_req = m_mxp_reads[ramu_req.reqid];
   m_mxp_reads.erase(ramu_req.reqid);
 
   assert(ramu_req.reqid == cxl_req->m_id);
 
   --m_mxp_requestsInFlight;
-  m_mxp_resp_queue.push_back(cxl_req);
+  if (cxl_req->m_traced) {
+    m_simBase->m_trace->req_span(cxl_req, "dram", cxl_req->m_trace_cycle, 
+                                 m_cycle);
+    cxl_req->m_trace_cycle = m_cycle;
+  }
+  push_resp(cxl_req);
 }
 
 // ramulator write callback
 void cxlt3_c::writeComplete(ramulator::Request &ramu_req) {
-  if (*KNOB(KNOB_DEBUG_CALLBACK)) {
+  if (CFG(KNOB_DEBUG_CALLBACK)) {
     printf("CXL RAM write callback done: 0x%lu\n", ramu_req.reqid);
   }
 
@@ -206,7 +851,62 @@ void cxlt3_c::writeComplete(ramulator::Request &ramu_req) {
   assert(ramu_req.reqid == cxl_req->m_id);
 
   --m_mxp_requestsInFlight;
-  m_mxp_resp_queue.push_back(cxl_req);
+  if (cxl_req->m_traced) {
+    m_simBase->m_trace->req_span(cxl_req, "dram", cxl_req->m_trace_cycle, 
+                                 m_cycle);
+    cxl_req->m_trace_cycle = m_cycle;
+  }
+  push_resp(cxl_req);
+}
+
+// ramulator write callback for lines drained from the write buffer
+void cxlt3_c::wbuffComplete(ramulator::Request &ramu_req) {
+  if (CFG(KNOB_DEBUG_CALLBACK)) {
+    printf("CXL RAM write buffer drain done: 0x%lu\n", ramu_req.reqid);
+  }
+
+  auto iter = m_wbuff_inflight.find(ramu_req.reqid);
+  assert(iter != m_wbuff_inflight.end());
+
+  wbuff_entry_s* entry = iter->second;
+  m_wbuff_inflight.erase(iter);
+  m_wbuff.remove(entry);
+  delete entry;
+
+  --m_mxp_requestsInFlight;
+}
+
+// ramulator read callback for prefetches
+void cxlt3_c::prefComplete(ramulator::Request &ramu_req) {
+  if (CFG(KNOB_DEBUG_CALLBACK)) {
+    printf("CXL RAM prefetch done: 0x%lu\n", ramu_req.reqid);
+  }
+
+  auto iter = m_pref_inflight.find(ramu_req.reqid);
+  assert(iter != m_pref_inflight.end());
+
+  pref_line_s* pref_line = iter->second;
+  m_pref_inflight.erase(iter);
+  --m_mxp_requestsInFlight;
+
+  // late prefetch : data goes straight to the waiting demand reads
+  if (!pref_line->m_waiting.empty()) {
+    for (auto req : pref_line->m_waiting) {
+      push_resp(req);
+    }
+    m_pref_lines.remove(pref_line);
+    delete pref_line;
+    return;
+  }
+
+  // invalidated by a write while in the dram
+  if (!pref_line->m_valid) {
+    m_pref_lines.remove(pref_line);
+    delete pref_line;
+    return;
+  }
+
+  pref_line->m_ready = true;
 }
 
 // print for debugging
@@ -214,9 +914,11 @@ void cxlt3_c::print_cxlt3_info() {
   std::cout << "-------------- mxp ------------------" << std::endl;
   print_ep_info();
 
-  std::cout << "pending q" << ": ";
-  for (auto req : *m_pending_req) {
-    std::cout << req->m_addr << " ; ";
+  for (int ii = 0; ii < m_num_ld; ++ii) {
+    std::cout << "pending q " << ii << ": ";
+    for (auto req : m_pending_req[ii]) {
+      std::cout << req->m_addr << " ; ";
+    }
   }
 
   std::cout << m_mxp_requestsInFlight << std::endl;
@@ -235,7 +937,54 @@ void cxlt3_c::print_cxlt3_info() {
     std::cout << req->m_id << "; ";
     std::cout << std::endl;
   }
+
+  if (m_pref->enabled()) {
+    m_pref->print();
+    std::cout << "Prefetch buff: ";
+    for (auto pref_line : m_pref_lines) {
+      std::cout << pref_line->m_addr << (pref_line->m_ready ? " ; " : "* ; ");
+    }
+    std::cout << std::endl;
+  }
+
+  if (m_wbuff_enable) {
+    std::cout << "Write buff" << (m_wbuff_drain ? " (drain)" : "") << ": ";
+    for (auto entry : m_wbuff) {
+      std::cout << entry->m_addr << (entry->m_issued ? "* ; " : " ; ");
+    }
+    std::cout << std::endl;
+  }
   std::cout << std::endl;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
+mxp_port_c::mxp_port_c(cxlsim_c* simBase, cxlt3_c* dev, int ld)
+  : pcie_ep_c(simBase), m_dev(dev), m_ld(ld) {
+}
+
+// same stage order as the device port
+void mxp_port_c::run_a_cycle(bool pll_locked) {
+  process_txphys();
+  process_txdll();
+  process_txtrans();
+  start_transaction();
+
+  end_transaction();
+  process_rxtrans();
+  process_rxdll();
+  process_rxphys();
+
+  m_cycle++;
+}
+
+void mxp_port_c::start_transaction() {
+  m_dev->send_resp(m_ld, CFG(KNOB_PCIE_TXVC_BW), 
+                   [this](cxl_req_s* req) { return push_txvc(req); });
+}
+
+void mxp_port_c::end_transaction() {
+  m_dev->recv_req(m_ld, [this]() { return pull_rxvc(); });
+}
+
 }
@@ -42,11 +42,14 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <list>
 #include <map>
 #include <tuple>
+#include <vector>
+#include <functional>
 
 #include "cxlsim.h"
 #include "pcie_endpoint.h"
 #include "packet_info.h"
 
+#include "mxp_prefetcher.h"
 #include "ramulator_wrapper.h"
 #include "ramulator/src/Request.h"
 #include "ramulator/src/Config.h"
@@ -54,8 +57,44 @@ POSSIBILITY OF SUCH DAMAGE.
 
 namespace cxlsim {
 
+// write buffer entry : one cacheline waiting to be written to the dram
+typedef struct wbuff_entry_s {
+  Addr m_addr; /**< cacheline address */
+  int m_merged; /**< number of writes merged into this entry */
+  bool m_issued; /**< drained to dram, waiting for completion */
+  Counter m_insert_cycle; /**< cycle the entry was allocated */
+} wbuff_entry_s;
+
+// prefetch buffer entry : one cacheline prefetched from the dram
+typedef struct pref_line_s {
+  Addr m_addr; /**< cacheline address */
+  bool m_ready; /**< data returned from the dram */
+  bool m_valid; /**< not invalidated by a write */
+  Counter m_insert_cycle; /**< cycle the prefetch was issued */
+  std::list<cxl_req_s*> m_waiting; /**< demand reads waiting for the data */
+} pref_line_s;
+
+// dram commands of the ramulator command trace (precharges are part of the
+// energy of an activate)
+typedef enum DRAM_CMD_TYPE {
+  DRAM_CMD_ACT = 0, /**< activate */
+  DRAM_CMD_RD,      /**< read burst (with or without auto precharge) */
+  DRAM_CMD_WR,      /**< write burst (with or without auto precharge) */
+  DRAM_CMD_REF,     /**< refresh of a rank */
+  MAX_DRAM_CMD_TYPES
+} DRAM_CMD_TYPE;
+
+static const std::string dram_cmd_type_string[MAX_DRAM_CMD_TYPES] = {
+  "act",
+  "rd",
+  "wr",
+  "ref",
+};
+
 class cxlt3_c : public pcie_ep_c
 {
+  friend class mxp_port_c;
+
 public:
   /**
    * Constructor
@@ -77,6 +116,58 @@ public:
    */
   void run_a_cycle_internal(bool pll_locked);
 
+  /**
+   * Number of requests waiting for the dram
+   */
+  int pending_size();
+
+  /**
+   * Number of logical devices (one per host)
+   */
+  int num_ld();
+
+  /**
+   * Endpoint connected to the root complex of a host
+   * - port of LD 0 is the device itself
+   * - behind a switch, the device is the only port
+   */
+  pcie_ep_c* get_port(int ld);
+
+  /**
+   * Number of requests pending inside the dram
+   */
+  int dram_pending_size();
+
+  /**
+   * No request (demand, write buffer drain or prefetch) is inside the dram
+   */
+  bool dram_idle();
+
+  /**
+   * Save or restore the state (only while the dram is idle)
+   */
+  void checkpoint(checkpoint_c* ckpt) override;
+
+  /**
+   * Close the dram & count the commands of its trace (dram_energy_enable)
+   */
+  void finalize();
+
+  /**
+   * Dram commands of a type (set by finalize)
+   */
+  Counter get_dram_cmds(int type);
+
+  /**
+   * Energy (pJ) of the dram commands of a type
+   */
+  double get_dram_energy(int type);
+
+  /**
+   * Background energy (pJ) of the dram over the cycles the mxp was simulated
+   */
+  double get_dram_background_energy();
+
   /**
    * Print for debugging
    */
@@ -93,6 +184,44 @@ private:
    */
   void end_transaction() override;
 
+  /**
+   * Send up to budget responses of a LD through its port (push : tx vc
+   * insert of the port), returns the number sent
+   */
+  int send_resp(int ld, int budget, std::function<bool(cxl_req_s*)> push);
+
+  /**
+   * Receive requests of a LD from its port (pull : rx vc pull of the port)
+   * - ld -1 : link shared by all LDs, each request goes to the LD of its host
+   */
+  void recv_req(int ld, std::function<cxl_req_s*(void)> pull);
+
+  /**
+   * Queue a finished request to the response queue of its LD
+   */
+  void push_resp(cxl_req_s* req);
+
+  /**
+   * Device physical address of a host address in the range of a LD
+   */
+  Addr get_dpa(Addr addr, int ld);
+
+  /**
+   * LDs ordered by weighted service (least served first)
+   */
+  void get_ld_order(std::vector<int>& order);
+
+  /**
+   * A LD with no pending request gets one : catch its virtual time up with
+   * the busy LDs
+   */
+  void activate_ld(int ld);
+
+  /**
+   * A request of a LD left the pending queue (issued or served)
+   */
+  void serve_ld(int ld);
+
   /**
    * Process pending memory requests
    */
@@ -103,6 +232,52 @@ private:
    */
   bool push_ramu_req(cxl_req_s* req);
 
+  /**
+   * Process pending memory requests through the write buffer
+   */
+  void process_pending_req_wbuff();
+
+  /**
+   * Insert a write into the write buffer (merge if the line is pending)
+   */
+  bool insert_wbuff(cxl_req_s* req);
+
+  /**
+   * Check if the write buffer holds the cacheline of a request
+   */
+  bool wbuff_hit(Addr addr);
+
+  /**
+   * Update drain mode & issue buffered writes to ramulator
+   */
+  void drain_wbuff(bool reads_pending);
+
+  /**
+   * Get cacheline address
+   */
+  Addr get_line_addr(Addr addr);
+
+  /**
+   * Look up the prefetch buffer with an incoming request & train the
+   * prefetcher. Returns true if the prefetch buffer serves the request
+   */
+  bool access_pref_buff(cxl_req_s* req);
+
+  /**
+   * Issue prefetch candidates to ramulator using spare dram bandwidth
+   */
+  void issue_pref();
+
+  /**
+   * Evict the oldest unused prefetched line
+   */
+  bool evict_pref();
+
+  /**
+   * Compute the DevLoad level of a LD from its pending queue & dram occupancy
+   */
+  DEVLOAD_TYPE get_devload(int ld);
+
   /**
    * Read callback function
    */
@@ -113,23 +288,109 @@ private:
    */
   void writeComplete(ramulator::Request &ramu_req);
 
+  /**
+   * Write callback function for writes drained from the write buffer
+   */
+  void wbuffComplete(ramulator::Request &ramu_req);
+
+  /**
+   * Read callback function for prefetches
+   */
+  void prefComplete(ramulator::Request &ramu_req);
+
 private:
   // mxp queues
   unsigned int m_mxp_requestsInFlight;
   std::map<Counter, cxl_req_s*> m_mxp_reads;
   std::map<Counter, cxl_req_s*> m_mxp_writes;
-  std::list<cxl_req_s*> m_mxp_resp_queue;
+  std::list<cxl_req_s*>* m_mxp_resp_queue; /**< responses per LD */
 
   // members for ramulator
   ramulator::Config configs;
   ramulator::CXLRamulatorWrapper *m_ramu_wrapper;
   std::function<void(ramulator::Request &)> m_read_cb_func;
   std::function<void(ramulator::Request &)> m_write_cb_func;
+  std::function<void(ramulator::Request &)> m_wbuff_cb_func;
+  std::function<void(ramulator::Request &)> m_pref_cb_func;
+
+  int m_pending_cap; /**< pending queue capacity of each LD */
+  std::list<cxl_req_s*>* m_pending_req; /**< mem reqs pending per LD */
+
+  // multi-logical device
+  int m_num_ld; /**< number of LDs, LD i is bound to host i */
+  int m_ld_size_bits; /**< log2 of the capacity of each LD */
+  std::vector<int> m_ld_weight; /**< dram issue weight of each LD */
+  std::vector<double> m_ld_vtime; /**< virtual time : issued requests / weight */
+  double m_vtime; /**< virtual time of the last issued request */
+  std::vector<pcie_ep_c*> m_ports; /**< endpoint of each LD */
+  bool m_shared_link; /**< all LDs behind one link (cxl switch) */
+  int m_resp_ld; /**< LD sending responses first on the shared link */
+
+  // devload
+  int m_devload_thresh[MAX_DEVLOAD_TYPES]; /**< occupancy (%) of each level */
+  int m_devload_dram_cap; /**< dram occupancy regarded as 100% */
 
-  int m_pending_cap;
-  std::list<cxl_req_s*>* m_pending_req; /**< mem reqs pending */
+  // write buffer
+  bool m_wbuff_enable; /**< write buffer enabled */
+  bool m_wbuff_drain; /**< write drain mode */
+  int m_wbuff_cap; /**< write buffer capacity */
+  int m_wbuff_hwm; /**< enter drain mode at this occupancy */
+  int m_wbuff_lwm; /**< leave drain mode at this occupancy */
+  Counter m_wbuff_uid; /**< ramulator request id of drained writes */
+  std::list<wbuff_entry_s*> m_wbuff; /**< write buffer in arrival order */
+  std::map<Addr, wbuff_entry_s*> m_wbuff_pending; /**< lines not yet drained */
+  std::map<Counter, wbuff_entry_s*> m_wbuff_inflight; /**< drained lines */
+
+  // prefetcher
+  mxp_prefetcher_c* m_pref; /**< prefetch candidate generator */
+  int m_pref_buff_cap; /**< prefetch buffer capacity */
+  int m_pref_queue_cap; /**< prefetch candidate queue capacity */
+  int m_pref_throttle; /**< max dram occupancy to issue prefetches */
+  Counter m_pref_uid; /**< ramulator request id of prefetches */
+  std::list<Addr> m_pref_queue; /**< prefetch candidates */
+  std::list<pref_line_s*> m_pref_lines; /**< prefetched lines in issue order */
+  std::map<Addr, pref_line_s*> m_pref_buff; /**< valid prefetched lines */
+  std::map<Counter, pref_line_s*> m_pref_inflight; /**< prefetches in dram */
 
   Counter m_cycle_internal; /**< internal cycle for DRAM */
+
+  // dram energy
+  bool m_dram_energy_enable; /**< record the ramulator command trace */
+  double m_dram_cmd_energy[MAX_DRAM_CMD_TYPES]; /**< pJ per command */
+  Counter m_dram_cmds[MAX_DRAM_CMD_TYPES]; /**< commands issued (set by finalize) */
+};
+
+// additional port of a multi-logical device : link to the root complex of
+// another host, requests are queued in the LD of that host
+class mxp_port_c : public pcie_ep_c
+{
+public:
+  /**
+   * Constructor
+   */
+  mxp_port_c(cxlsim_c* simBase, cxlt3_c* dev, int ld);
+
+  /**
+   * Tick a cycle
+   */
+  void run_a_cycle(bool pll_locked) override;
+
+private:
+  mxp_port_c(); // do not implement
+
+  /**
+   * Send responses of the LD
+   */
+  void start_transaction() override;
+
+  /**
+   * Move requests into the LD pending queue
+   */
+  void end_transaction() override;
+
+private:
+  cxlt3_c* m_dev; /**< memory expander */
+  int m_ld; /**< logical device of the port */
 };
 
 } //namespace ramulator
@@ -35,70 +35,102 @@ POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************************************/
 
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
 
 #include "cxlsim.h"
 #include "pcie_rc.h"
 #include "cxl_t3.h"
+#include "cxl_switch.h"
+#include "checkpoint.h"
+#include "latency_hist.h"
+#include "interval_stat.h"
+#include "trace_event.h"
+#include "sim_profile.h"
+#include "sampler.h"
 #include "packet_info.h"
 #include "utils.h"
+#include "assert_macros.h"
 #include "statistics.h"
 #include "all_knobs.h"
 #include "all_stats.h"
+#include "statsEnums.h"
 
 namespace cxlsim {
 
-#define GET_NEXT_CYCLE(domain)              \
-  ++m_domain_count[domain];                 \
-  m_domain_next[domain] = static_cast<int>( \
-    1.0 * m_clock_lcm * m_domain_count[domain] / m_domain_freq[domain]);
-
-
-int get_gcd(int a, int b) {
-  if (b == 0) return a;
-
-  return get_gcd(b, a % b);
-}
-
-int get_lcm(int a, int b) {
-  return (a * b) / get_gcd(a, b);
-}
-
-
 ///////////////////////////////////////////////////////////////////////////////
 // public
 ///////////////////////////////////////////////////////////////////////////////
 
-Counter cxlsim_c::m_req_id;
-
 cxlsim_c::cxlsim_c() {
   // simulation related
   m_cycle = 0;
+  m_req_id = 0;
+  m_msg_uid = 0;
+  m_slot_uid = 0;
+  m_flit_uid = 0;
 
   // memory pool for packets
   m_req_pool = new pool_c<cxl_req_s>;
   m_msg_pool = new pool_c<message_s>;
   m_slot_pool = new pool_c<slot_s>;
   m_flit_pool = new pool_c<flit_s>;
-  m_trans_done_cb = NULL;
-
-  // clock domain
-  m_clock_lcm = 1;
-  m_domain_freq = new int[2];
-  m_domain_count = new int[2];
-  m_domain_next = new int[2];
-  m_clock_internal = 0;
+  m_num_hosts = 1;
+  m_rc = NULL;
+  m_mxp = NULL;
+  m_switch = NULL;
+  m_early_done_cb = NULL;
+  m_cfg = NULL;
+  m_knobsContainer = NULL;
+  m_knobs = NULL;
+  m_allStats = NULL;
+  m_ProcessorStats = NULL;
+  m_coreStatsTemplate = NULL;
+  m_stat_counters = NULL;
+  m_read_lat_hist = NULL;
+  m_write_lat_hist = NULL;
+  m_interval_stat = NULL;
+  m_trace = NULL;
+  m_profile = NULL;
+  m_sampler = NULL;
+  m_inflight_reqs = 0;
 }
 
 cxlsim_c::~cxlsim_c() {
-  delete m_rc;
-  delete m_mxp;
+  for (auto rc : m_rcs) {
+    delete rc;
+  }
+  for (auto mxp : m_mxps) {
+    delete mxp;
+  }
+  delete m_switch;
   delete m_req_pool;
   delete m_msg_pool;
   delete m_slot_pool;
   delete m_flit_pool;
-  delete m_domain_freq;
-  delete m_domain_count;
-  delete m_domain_next;
+  delete m_read_lat_hist;
+  delete m_write_lat_hist;
+  for (int ii = 0; ii < (int)m_host_read_hist.size(); ++ii) {
+    delete m_host_read_hist[ii];
+    delete m_host_write_hist[ii];
+  }
+  delete m_interval_stat;
+  delete m_trace;
+  delete m_profile;
+  delete m_sampler;
+  delete m_cfg;
+
+  for (auto& stream : m_AllStatsOutputStreams) {
+    stream.second->close();
+    delete stream.second;
+  }
+  delete m_allStats;
+  delete m_ProcessorStats;
+  delete m_coreStatsTemplate;
+  delete m_knobsContainer;
 }
 
 void cxlsim_c::init(int argc, char** argv) {
@@ -106,18 +138,50 @@ void cxlsim_c::init(int argc, char** argv) {
   init_stats();
   init_sim_objects();
   init_clock_domain();
+
+  m_interval_stat = new interval_stat_c(this);
+  m_trace = new trace_event_c(this);
+  m_profile = new sim_profile_c(this);
+  m_sampler = new sampler_c(this);
+}
+
+void cxlsim_c::register_callback(callback_t* fn, int host) {
+  ASSERTM((host >= 0 && host < m_num_hosts), "host should be in [0, num_hosts)\n");
+  if ((int)m_trans_done_cb.size() <= host) {
+    m_trans_done_cb.resize(host + 1, NULL);
+  }
+  m_trans_done_cb[host] = fn;
 }
 
-void cxlsim_c::register_callback(callback_t* fn) {
-  m_trans_done_cb = fn;
+void cxlsim_c::register_early_callback(callback_t* fn) {
+  m_early_done_cb = fn;
+}
+
+void cxlsim_c::set_total_reqs(Counter total) {
+  m_profile->set_total_reqs(total);
 }
 
 // accept request from the outside simulator
-Counter cxlsim_c::insert_request(Addr addr, bool write, void* req) {
-  if (m_rc->rootcomplex_full()) {
+Counter cxlsim_c::insert_request(Addr addr, bool write, void* req, int host) {
+  ASSERTM((host >= 0 && host < m_num_hosts), "host should be in [0, num_hosts)\n");
+
+  // fast-forward : complete at the end of this cycle without the link & dram
+  if (m_sampler->fast_forward()) {
+    cxl_req_s* new_req = m_req_pool->acquire_entry(this);
+    new_req->m_id = ++m_req_id;
+    new_req->m_addr = addr;
+    new_req->m_write = write;
+    new_req->m_req = req;
+    new_req->m_host = host;
+    m_functional_q.push_back(new_req);
+    m_stat_counters[SAMPLE_FUNCTIONAL_REQS]++;
+    return m_req_id;
+  }
+
+  if (m_rcs[host]->rootcomplex_full()) {
     return 0;
   } else {
-    if (m_knobs->KNOB_DEBUG_CALLBACK->getValue()) {
+    if (m_cfg->KNOB_DEBUG_CALLBACK) {
       std::cout << "==== Insert req to MXP"
         << " Addr: " << addr
         << std::dec << " write: " << write << std::endl;
@@ -126,59 +190,104 @@ Counter cxlsim_c::insert_request(Addr addr, bool write, void* req) {
     cxl_req_s* new_req = m_req_pool->acquire_entry(this);
     new_req->m_id = ++m_req_id;
     new_req->m_addr = addr;
+    new_req->m_dpa = addr;
     new_req->m_write = write;
     new_req->m_req = req;
+    new_req->m_host = host;
+    new_req->m_issue_cycle = m_cycle;
+    m_trace->start_req(new_req);
 
-    m_rc->insert_request(new_req);
+    m_rcs[host]->insert_request(new_req);
+    m_inflight_reqs++;
     return m_req_id;
   }
 }
 
 void cxlsim_c::run_a_cycle(bool pll_locked) {
+  PROFILE_SCOPE(m_profile, PROF_RUN_A_CYCLE);
+
+  // fast-forward with every request drained : the detailed model is not
+  // ticked, its clocks resume at the next warm-up
+  bool detailed = !(m_sampler->fast_forward() && m_inflight_reqs == 0);
+  if (!detailed) {
+    m_stat_counters[SAMPLE_SKIPPED_CYCLES]++;
+  }
+
   // run root complex & memory expander
   // - from the viewpoint of the external simulator, the interconnect should 
   //   run_a_cycle whenever cxlsim_c::run_a_cycle is called
-  m_mxp->run_a_cycle(pll_locked);
-  m_rc->run_a_cycle(pll_locked);
-  GET_NEXT_CYCLE(CLOCK_IO);
+  run_domain(CLOCK_IO, pll_locked, detailed);
+  m_clocks[CLOCK_IO].advance();
+
+  // run the edges of the other domains up to the next io edge in time
+  // order (simultaneous edges in domain order)
+  uint64_t io_next = m_clocks[CLOCK_IO].next();
+  while (true) {
+    int domain = -1;
+    for (int ii = CLOCK_IO + 1; ii < CLOCK_DOMAIN_COUNT; ++ii) {
+      if (m_clocks[ii].next() < io_next &&
+          (domain == -1 || m_clocks[ii].next() < m_clocks[domain].next())) {
+        domain = ii;
+      }
+    }
+    if (domain == -1) {
+      break;
+    }
+    run_domain(domain, pll_locked, detailed);
+    m_clocks[domain].advance();
+  }
 
-  // run dram inside the memory expander
-  // - should run only when the timing is correct
-  while (m_clock_internal <= m_domain_next[CLOCK_CXLRAM] &&
-      m_domain_next[CLOCK_CXLRAM] < m_domain_next[CLOCK_IO]) {
-    m_mxp->run_a_cycle_internal(pll_locked);
-    GET_NEXT_CYCLE(CLOCK_CXLRAM);
+  // pull early completed requests from the root complex
+  // - must come first as the full completion releases the request
+  for (auto rc : m_rcs) {
+    while (1) {
+      cxl_req_s* early_req = rc->pop_early_request();
+      if (early_req == NULL) {
+        break;
+      } else {
+        request_early_done(early_req);
+      }
+    }
   }
-/* #endif */
 
   // pull finished requests from the root complex
-  while (1) {
-    cxl_req_s* finished_req = m_rc->pop_request();
-    if (finished_req == NULL) { // no finished request
-      break;
-    } else { // call the callback function & return to req pool
-      request_done(finished_req);
+  for (auto rc : m_rcs) {
+    while (1) {
+      cxl_req_s* finished_req = rc->pop_request();
+      if (finished_req == NULL) { // no finished request
+        break;
+      } else { // call the callback function & return to req pool
+        request_done(finished_req);
+      }
     }
   }
+  functional_done();
 
   // update external clock 
   m_cycle++;
 
-  // update internal clock
-  m_clock_internal += static_cast<int>(1.0 * m_clock_lcm / 
-                                       m_domain_freq[CLOCK_IO]);
-  if (m_clock_internal == m_clock_lcm) {
-    m_clock_internal = 0;
-    for (int ii = 0; ii < 2; ii++) {
-      m_domain_count[ii] = 0;
-      m_domain_next[ii] = 0;
-    }
+  // interval stats
+  if (m_interval_stat->enabled()) {
+    m_interval_stat->run_a_cycle();
+  }
+
+  // trace counters
+  if (m_trace->enabled()) {
+    m_trace->run_a_cycle();
+  }
+
+  // progress line
+  m_profile->run_a_cycle();
+
+  // sampling windows
+  if (m_sampler->enabled()) {
+    m_sampler->run_a_cycle();
   }
 
   // print messages for debugging
 /* if (m_knobs->KNOB_DEBUG_IO_SYS->getValue() || */
 /* (m_cycle % m_knobs->KNOB_FORWARD_PROGRESS_PERIOD->getValue() == 0)) { */
-  if (m_knobs->KNOB_DEBUG_IO_SYS->getValue()) {
+  if (m_cfg->KNOB_DEBUG_IO_SYS) {
     std::cout << std::endl << "io cycle : " << std::dec << m_cycle << std::endl;
     print();
   }
@@ -186,7 +295,21 @@ void cxlsim_c::run_a_cycle(bool pll_locked) {
 
 void cxlsim_c::finalize() {
   // dump stats
+  m_interval_stat->finalize();
+  m_trace->finalize();
+  save_latency_stats();
+  save_link_energy();
+  save_energy();
   m_ProcessorStats->saveStats();
+  save_latency_hist();
+  save_host_stats();
+  save_link_stats();
+  save_energy_stats();
+  if (m_switch) {
+    m_switch->finalize();
+  }
+  m_sampler->finalize();
+  m_profile->finalize();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -195,11 +318,41 @@ void cxlsim_c::finalize() {
 
 void cxlsim_c::init_sim_objects() {
   // io devices
-  m_rc = new pcie_rc_c(this);
-  m_mxp = new cxlt3_c(this);
+  // - every host has a root complex linked to its own port of the mxp, or
+  //   to an upstream port of the switch when the mxps sit behind one
+  m_num_hosts = m_cfg->KNOB_NUM_HOSTS;
+  ASSERTM(m_num_hosts > 0, "num_hosts should be at least 1\n");
+  int num_mxps = 1;
+  if (m_cfg->KNOB_SWITCH_ENABLE) {
+    m_switch = new cxl_switch_c(this);
+    num_mxps = m_cfg->KNOB_SWITCH_NUM_DEVICES;
+  }
+  for (int ii = 0; ii < num_mxps; ++ii) {
+    m_mxps.push_back(new cxlt3_c(this));
+  }
+  m_mxp = m_mxps[0];
+
+  int id = 0;
+  for (int ii = 0; ii < m_num_hosts; ++ii) {
+    pcie_rc_c* rc = new pcie_rc_c(this);
+    pcie_ep_c* port = m_switch ? m_switch->get_usp(ii) : m_mxp->get_port(ii);
 
-  m_rc->init( 0, true,   m_msg_pool, m_slot_pool, m_flit_pool, m_mxp);
-  m_mxp->init(1, false,  m_msg_pool, m_slot_pool, m_flit_pool, m_rc);
+    // link ii : host ii
+    rc->init(id++, ii, true, m_msg_pool, m_slot_pool, m_flit_pool, port);
+    port->init(id++, ii, false, m_msg_pool, m_slot_pool, m_flit_pool, rc);
+    m_rcs.push_back(rc);
+  }
+  m_rc = m_rcs[0];
+
+  for (int ii = 0; m_switch && ii < num_mxps; ++ii) {
+    pcie_ep_c* port = m_switch->get_dsp(ii);
+
+    // links after the hosts : switch downstream ports
+    int link = m_num_hosts + ii;
+    port->init(id++, link, true, m_msg_pool, m_slot_pool, m_flit_pool, m_mxps[ii]);
+    m_mxps[ii]->init(id++, link, false, m_msg_pool, m_slot_pool, m_flit_pool, port);
+  }
+  m_trans_done_cb.resize(m_num_hosts, NULL);
 }
 
 void cxlsim_c::init_knobs(int argc, char** argv) {
@@ -220,6 +373,11 @@ void cxlsim_c::init_knobs(int argc, char** argv) {
 
   // save the states of all knobs to a file
   m_knobsContainer->saveToFile("cxl_params.out");
+
+  // snapshot the knob values so that hot loops read plain fields
+  m_cfg = new knob_config_s;
+  bool cfg_valid = m_knobs->snapshot(m_cfg);
+  ASSERTM(cfg_valid, "knob differs from the value frozen at compile time");
 }
 
 void cxlsim_c::init_stats() {
@@ -230,65 +388,495 @@ void cxlsim_c::init_stats() {
   // init all stats
   m_allStats = new all_stats_c(m_ProcessorStats);
   m_allStats->initialize(m_ProcessorStats, m_coreStatsTemplate);
+  m_stat_counters = m_allStats->m_counters;
+
+  // latency histograms
+  m_read_lat_hist = new latency_hist_c(m_cfg->KNOB_LATENCY_HIST_SUB_BITS);
+  m_write_lat_hist = new latency_hist_c(m_cfg->KNOB_LATENCY_HIST_SUB_BITS);
+  for (int ii = 0; ii < m_cfg->KNOB_NUM_HOSTS; ++ii) {
+    m_host_read_hist.push_back(new latency_hist_c(m_cfg->KNOB_LATENCY_HIST_SUB_BITS));
+    m_host_write_hist.push_back(new latency_hist_c(m_cfg->KNOB_LATENCY_HIST_SUB_BITS));
+  }
 }
 
 void cxlsim_c::init_clock_domain() {
-  const int domain_cnt = 2;
-  float freq[domain_cnt];
-
-  freq[0] = m_knobs->KNOB_CLOCK_IO->getValue();
-  freq[1] = m_knobs->KNOB_CLOCK_CXLRAM->getValue();
-
-  // allow only .x format
-  for (int ii = 0; ii < 1; ++ii) {
-    bool found = false;
-    for (int jj = 0; jj < domain_cnt; ++jj) {
-      int int_cast = static_cast<int>(freq[jj]);
-      float float_cast = static_cast<float>(int_cast);
-      if (freq[jj] != float_cast) {
-        found = true;
-        break;
-      }
-    }
+  // any frequency : edges live on a picosecond timebase
+  m_clocks[CLOCK_IO].init(m_cfg->KNOB_CLOCK_IO);
+  m_clocks[CLOCK_CXLRAM].init(m_cfg->KNOB_CLOCK_CXLRAM);
+}
 
-    if (found) {
-      for (int jj = 0; jj < domain_cnt; ++jj) {
-        freq[jj] *= 10;
-      }
-    } else {
-      break;
-    }
+void cxlsim_c::run_domain(int domain, bool pll_locked, bool detailed) {
+  // the clocks keep running while the detailed model is skipped
+  if (!detailed) {
+    return;
   }
 
-  m_domain_freq[0] = static_cast<int>(freq[0]);
-  m_domain_freq[1] = static_cast<int>(freq[1]);
-
-  m_clock_lcm = m_domain_freq[0];
-  for (int ii = 1; ii < domain_cnt; ii++) {
-    m_clock_lcm = get_lcm(m_clock_lcm, m_domain_freq[ii]);
+  switch (domain) {
+    case CLOCK_IO:
+      for (auto mxp : m_mxps) {
+        mxp->run_a_cycle(pll_locked);
+      }
+      if (m_switch) {
+        m_switch->run_a_cycle(pll_locked);
+      }
+      for (auto rc : m_rcs) {
+        rc->run_a_cycle(pll_locked);
+      }
+      break;
+    case CLOCK_CXLRAM:
+      // dram inside the memory expander
+      for (auto mxp : m_mxps) {
+        mxp->run_a_cycle_internal(pll_locked);
+      }
+      break;
+    default:
+      ASSERTM(0, "unknown clock domain\n");
   }
 }
 
 void cxlsim_c::request_done(cxl_req_s* req) {
   // call registered callback function if it has one
-  if (m_trans_done_cb) {
-    if (m_knobs->KNOB_DEBUG_CALLBACK->getValue()) {
+  callback_t* done_cb = NULL;
+  if (req->m_host < (int)m_trans_done_cb.size()) {
+    done_cb = m_trans_done_cb[req->m_host];
+  }
+  if (done_cb == NULL && !m_trans_done_cb.empty()) {
+    done_cb = m_trans_done_cb[0];
+  }
+
+  if (done_cb) {
+    if (m_cfg->KNOB_DEBUG_CALLBACK) {
       std::cout << "CXL Req Done: "
                 << "Addr: " << req->m_addr << " " 
                 << std::dec << "Write: " << req->m_write << " " << std::endl;
     }
 
-    (*m_trans_done_cb)(req->m_addr, req->m_write, req->m_id, req->m_req);
+    (*done_cb)(req->m_addr, req->m_write, req->m_id, req->m_req);
   }
 
+  // end-to-end latency
+  Counter latency = m_cycle - req->m_issue_cycle;
+  m_inflight_reqs--;
+  if (m_sampler->enabled()) {
+    m_sampler->record_latency(req->m_write, latency);
+  }
+  if (m_interval_stat->enabled()) {
+    m_interval_stat->record_latency(req->m_write, latency);
+  }
+  if (m_num_hosts > 1) {
+    if (req->m_write) {
+      m_host_write_hist[req->m_host]->record(latency);
+    } else {
+      m_host_read_hist[req->m_host]->record(latency);
+    }
+  }
+  if (req->m_write) {
+    m_write_lat_hist->record(latency);
+    m_stat_counters[E2E_WRITE_BASE]++;
+    m_stat_counters[AVG_E2E_WRITE_LATENCY] += latency;
+  } else {
+    m_read_lat_hist->record(latency);
+    m_stat_counters[E2E_READ_BASE]++;
+    m_stat_counters[AVG_E2E_READ_LATENCY] += latency;
+  }
+
+  if (req->m_traced) {
+    m_trace->end_req(req);
+  }
+  m_profile->req_done();
+
   // release cxl request entry
   req->init();
   m_req_pool->release_entry(req);
 }
 
+void cxlsim_c::request_early_done(cxl_req_s* req) {
+  if (m_early_done_cb) {
+    if (m_cfg->KNOB_DEBUG_CALLBACK) {
+      std::cout << "CXL Req Early Done: "
+                << "Addr: " << req->m_addr << " " 
+                << std::dec << "Write: " << req->m_write << " " << std::endl;
+    }
+
+    (*m_early_done_cb)(req->m_addr, req->m_write, req->m_id, req->m_req);
+  }
+}
+
+void cxlsim_c::functional_done() {
+  while (!m_functional_q.empty()) {
+    cxl_req_s* req = m_functional_q.front();
+    m_functional_q.pop_front();
+
+    callback_t* done_cb = NULL;
+    if (req->m_host < (int)m_trans_done_cb.size()) {
+      done_cb = m_trans_done_cb[req->m_host];
+    }
+    if (done_cb == NULL && !m_trans_done_cb.empty()) {
+      done_cb = m_trans_done_cb[0];
+    }
+    if (done_cb) {
+      (*done_cb)(req->m_addr, req->m_write, req->m_id, req->m_req);
+    }
+    m_profile->req_done();
+
+    req->init();
+    m_req_pool->release_entry(req);
+  }
+}
+
+void cxlsim_c::save_latency_stats() {
+  const int pct_cnt = 4;
+  const double pct[pct_cnt] = {50.0, 90.0, 99.0, 99.9};
+
+  // percentile stats follow E2E_*_LATENCY_P50 in io.stat.def order
+  for (int ii = 0; ii < pct_cnt; ii++) {
+    m_stat_counters[E2E_READ_LATENCY_P50 + ii] += m_read_lat_hist->percentile(pct[ii]);
+    m_stat_counters[E2E_WRITE_LATENCY_P50 + ii] += m_write_lat_hist->percentile(pct[ii]);
+  }
+  m_stat_counters[E2E_READ_LATENCY_MAX] += m_read_lat_hist->max();
+  m_stat_counters[E2E_WRITE_LATENCY_MAX] += m_write_lat_hist->max();
+}
+
+void cxlsim_c::save_latency_hist() {
+  std::ofstream* stream = get_output_stream("latency_hist.out");
+  if (stream != NULL) {
+    m_read_lat_hist->print(*stream, "E2E_READ_LATENCY");
+    m_write_lat_hist->print(*stream, "E2E_WRITE_LATENCY");
+  }
+}
+
+// per host : completed requests, latency (io cycles) & payload bandwidth of
+// its link in each direction
+void cxlsim_c::save_host_stats() {
+  if (m_num_hosts == 1) {
+    return;
+  }
+
+  std::ofstream* stream = get_output_stream("host.stat.out");
+  if (stream == NULL) {
+    return;
+  }
+
+  std::ofstream& out = *stream;
+  double freq = m_cfg->KNOB_CLOCK_IO;
+  double cycles = m_cycle ? static_cast<double>(m_cycle) : 1.0;
+  out << "host,rd_done,wr_done,rd_avg,rd_p50,rd_p99,rd_max,"
+      << "wr_avg,wr_p50,wr_p99,wr_max,m2s_gbps,s2m_gbps" << std::endl;
+  for (int ii = 0; ii < m_num_hosts; ++ii) {
+    latency_hist_c* rd = m_host_read_hist[ii];
+    latency_hist_c* wr = m_host_write_hist[ii];
+    pcie_rc_c* rc = m_rcs[ii];
+
+    out << std::fixed << std::setprecision(2) << ii << ","
+        << rd->count() << "," << wr->count() << ","
+        << (rd->count() ? 1.0 * rd->sum() / rd->count() : 0.0) << ","
+        << rd->percentile(50.0) << "," << rd->percentile(99.0) << ","
+        << rd->max() << ","
+        << (wr->count() ? 1.0 * wr->sum() / wr->count() : 0.0) << ","
+        << wr->percentile(50.0) << "," << wr->percentile(99.0) << ","
+        << wr->max() << ","
+        << rc->m_txphys_bits * freq / cycles << ","
+        << rc->m_peer_ep->m_txphys_bits * freq / cycles << std::endl;
+  }
+}
+
+std::vector<pcie_ep_c*> cxlsim_c::get_link_endpoints() {
+  std::vector<pcie_ep_c*> eps;
+  for (auto rc : m_rcs) {
+    eps.push_back(rc);
+    eps.push_back(rc->m_peer_ep);
+  }
+  for (int ii = 0; m_switch && ii < (int)m_mxps.size(); ++ii) {
+    eps.push_back(m_switch->get_dsp(ii));
+    eps.push_back(m_mxps[ii]);
+  }
+  return eps;
+}
+
+void cxlsim_c::save_link_energy() {
+  double dynamic = 0.0;
+  double stat = 0.0;
+  for (auto ep : get_link_endpoints()) {
+    dynamic += ep->get_dynamic_energy();
+    stat += ep->get_static_energy();
+  }
+  m_stat_counters[PCIE_DYNAMIC_ENERGY_PJ] = static_cast<uint64_t>(std::llround(dynamic));
+  m_stat_counters[PCIE_STATIC_ENERGY_PJ] = static_cast<uint64_t>(std::llround(stat));
+}
+
+void cxlsim_c::save_link_stats() {
+  std::ofstream* stream = get_output_stream("link.stat.out");
+  if (stream == NULL) {
+    return;
+  }
+
+  std::ofstream& out = *stream;
+  double freq = m_cfg->KNOB_CLOCK_IO;
+  out << "link,dir,lanes,l0,l0p,l1,tx_gbps,dynamic_pj,static_pj,avg_mw" << std::endl;
+  std::vector<pcie_ep_c*> eps = get_link_endpoints();
+  for (int ii = 0; ii < (int)eps.size(); ++ii) {
+    pcie_ep_c* ep = eps[ii];
+    Counter cycles = 0;
+    for (int jj = 0; jj < MAX_LINK_POWER_STATES; ++jj) {
+      cycles += ep->m_power_cycles[jj];
+    }
+    double total = cycles ? static_cast<double>(cycles) : 1.0;
+    double energy = ep->get_dynamic_energy() + ep->get_static_energy();
+
+    // residency in percent, pJ over the run (total / clock_io ns) : mW
+    out << std::fixed << std::setprecision(2) << ii / 2 << ","
+        << (ii % 2 ? "s2m" : "m2s") << "," << ep->get_tx_lanes();
+    for (int jj = 0; jj < MAX_LINK_POWER_STATES; ++jj) {
+      out << "," << 100.0 * ep->m_power_cycles[jj] / total;
+    }
+    out << "," << ep->m_txphys_bits * freq / total << ","
+        << ep->get_dynamic_energy() << "," << ep->get_static_energy() << ","
+        << energy * freq / total << std::endl;
+  }
+}
+
+void cxlsim_c::save_energy() {
+  double ctrl = m_stat_counters[PCIE_VCBUFF_MSGS] * m_cfg->KNOB_PCIE_VCBUFF_MSG_ENERGY +
+                m_stat_counters[MXP_CTRL_MSGS] * m_cfg->KNOB_MXP_CTRL_MSG_ENERGY;
+  double dram = 0.0;
+  for (auto mxp : m_mxps) {
+    mxp->finalize();
+    for (int ii = 0; ii < MAX_DRAM_CMD_TYPES; ++ii) {
+      m_stat_counters[DRAM_ACT_CMDS + ii] += mxp->get_dram_cmds(ii);
+      dram += mxp->get_dram_energy(ii);
+    }
+    dram += mxp->get_dram_background_energy();
+  }
+
+  // bytes delivered : data of the reads & writes the hosts got back
+  m_stat_counters[CTRL_ENERGY_PJ] = static_cast<uint64_t>(std::llround(ctrl));
+  m_stat_counters[DRAM_ENERGY_PJ] = static_cast<uint64_t>(std::llround(dram));
+  uint64_t total = m_stat_counters[PCIE_DYNAMIC_ENERGY_PJ] + 
+                   m_stat_counters[PCIE_STATIC_ENERGY_PJ] +
+                   m_stat_counters[CTRL_ENERGY_PJ] + m_stat_counters[DRAM_ENERGY_PJ];
+  m_stat_counters[TOTAL_ENERGY_PJ] = total;
+  m_stat_counters[ENERGY_BYTES_DELIVERED] = 
+    (m_stat_counters[E2E_READ_BASE] + m_stat_counters[E2E_WRITE_BASE]) * 
+    m_cfg->KNOB_RAMULATOR_CACHELINE_SIZE;
+  m_stat_counters[TOTAL_PJ_PER_BYTE] = total;
+  m_stat_counters[DRAM_PJ_PER_BYTE] = m_stat_counters[DRAM_ENERGY_PJ];
+}
+
+void cxlsim_c::save_energy_stats() {
+  std::ofstream* stream = get_output_stream("energy.stat.out");
+  if (stream == NULL) {
+    return;
+  }
+
+  std::vector<std::pair<std::string, double>> energy;
+  double dynamic = 0.0;
+  double stat = 0.0;
+  for (auto ep : get_link_endpoints()) {
+    dynamic += ep->get_dynamic_energy();
+    stat += ep->get_static_energy();
+  }
+  energy.push_back({"link_dynamic", dynamic});
+  energy.push_back({"link_static", stat});
+  energy.push_back({"vcbuff", m_stat_counters[PCIE_VCBUFF_MSGS] * 
+                              m_cfg->KNOB_PCIE_VCBUFF_MSG_ENERGY});
+  energy.push_back({"mxp_ctrl", m_stat_counters[MXP_CTRL_MSGS] * 
+                                m_cfg->KNOB_MXP_CTRL_MSG_ENERGY});
+  for (int ii = 0; ii < MAX_DRAM_CMD_TYPES; ++ii) {
+    double cmd = 0.0;
+    for (auto mxp : m_mxps) {
+      cmd += mxp->get_dram_energy(ii);
+    }
+    energy.push_back({"dram_" + dram_cmd_type_string[ii], cmd});
+  }
+  double background = 0.0;
+  for (auto mxp : m_mxps) {
+    background += mxp->get_dram_background_energy();
+  }
+  energy.push_back({"dram_background", background});
+
+  double total = 0.0;
+  for (auto& entry : energy) {
+    total += entry.second;
+  }
+  energy.push_back({"total", total});
+
+  // share in percent, pJ over the simulated cycles (/ clock_io ns) : mW
+  // - the energies only cover the cycles the detailed model ran, which
+  //   leaves out the cycles skipped by the sampler's fast-forward
+  std::ofstream& out = *stream;
+  double freq = m_cfg->KNOB_CLOCK_IO;
+  Counter detailed = m_cycle - m_stat_counters[SAMPLE_SKIPPED_CYCLES];
+  double cycles = detailed ? static_cast<double>(detailed) : 1.0;
+  double bytes = m_stat_counters[ENERGY_BYTES_DELIVERED] ? 
+                 static_cast<double>(m_stat_counters[ENERGY_BYTES_DELIVERED]) : 1.0;
+  out << "component,energy_pj,share,pj_per_byte,avg_mw" << std::endl;
+  for (auto& entry : energy) {
+    out << std::fixed << std::setprecision(2) << entry.first << ","
+        << entry.second << "," 
+        << (total > 0.0 ? 100.0 * entry.second / total : 0.0) << ","
+        << entry.second / bytes << "," << entry.second * freq / cycles << std::endl;
+  }
+}
+
+void cxlsim_c::register_checkpoint_tags(ckpt_save_tag_t save_tag, 
+                                        ckpt_load_tag_t load_tag) {
+  m_ckpt_save_tag = save_tag;
+  m_ckpt_load_tag = load_tag;
+}
+
+bool cxlsim_c::sampling_done() {
+  return m_sampler->done();
+}
+
+bool cxlsim_c::checkpoint_ready() {
+  for (auto mxp : m_mxps) {
+    if (!mxp->dram_idle()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool cxlsim_c::save_checkpoint(const std::string& path,
+                               std::function<void(checkpoint_c*)> outer) {
+  if (!checkpoint_ready()) {
+    return false;
+  }
+
+  checkpoint_c ckpt(this, m_req_pool, m_msg_pool, m_slot_pool, m_flit_pool);
+  ckpt.set_tags(m_ckpt_save_tag, m_ckpt_load_tag);
+  if (!ckpt.open(path, true)) {
+    return false;
+  }
+
+  checkpoint(&ckpt);
+  ckpt.mark("outer");
+  if (outer) {
+    outer(&ckpt);
+  }
+  return ckpt.close();
+}
+
+bool cxlsim_c::load_checkpoint(const std::string& path,
+                               std::function<void(checkpoint_c*)> outer) {
+  ASSERTM(m_cycle == 0, "restore a checkpoint before the first cycle\n");
+
+  checkpoint_c ckpt(this, m_req_pool, m_msg_pool, m_slot_pool, m_flit_pool);
+  ckpt.set_tags(m_ckpt_save_tag, m_ckpt_load_tag);
+  if (!ckpt.open(path, false)) {
+    return false;
+  }
+
+  checkpoint(&ckpt);
+  ckpt.mark("outer");
+  if (outer) {
+    outer(&ckpt);
+  }
+  return ckpt.close();
+}
+
+// components are visited in a fixed order, so a checkpoint restores only
+// into a simulator with the same topology & queue sizes
+void cxlsim_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->mark("cxlsim checkpoint v5");
+
+  int topology[4] = {m_num_hosts, (int)m_mxps.size(), m_switch != NULL, 
+                     GLOBAL_STATS_COUNT};
+  int saved[4] = {topology[0], topology[1], topology[2], topology[3]};
+  ckpt->io(saved);
+  bool same_topology = std::equal(saved, saved + 4, topology);
+  ASSERTM(same_topology, "checkpoint is from a different topology or build\n");
+
+  // clocks & uids
+  ckpt->io(m_cycle);
+  ckpt->io(m_req_id);
+  ckpt->io(m_inflight_reqs);
+  ckpt->io(m_msg_uid);
+  ckpt->io(m_slot_uid);
+  ckpt->io(m_flit_uid);
+  for (int ii = 0; ii < CLOCK_DOMAIN_COUNT; ++ii) {
+    m_clocks[ii].checkpoint(ckpt);
+  }
+
+  // stats
+  ckpt->mark("stats");
+  for (int ii = 0; ii < GLOBAL_STATS_COUNT; ++ii) {
+    ckpt->io(m_stat_counters[ii]);
+  }
+  m_read_lat_hist->checkpoint(ckpt);
+  m_write_lat_hist->checkpoint(ckpt);
+  for (int ii = 0; ii < m_num_hosts; ++ii) {
+    m_host_read_hist[ii]->checkpoint(ckpt);
+    m_host_write_hist[ii]->checkpoint(ckpt);
+  }
+  m_interval_stat->checkpoint(ckpt);
+  m_trace->checkpoint(ckpt);
+  m_sampler->checkpoint(ckpt);
+
+  // packets in flight
+  ckpt->mark("devices");
+  for (auto rc : m_rcs) {
+    rc->checkpoint(ckpt);
+  }
+  if (m_switch) {
+    m_switch->checkpoint(ckpt);
+  }
+  for (auto mxp : m_mxps) {
+    mxp->checkpoint(ckpt);
+  }
+}
+
+// stat files of this instance, opened on first use & closed by the destructor
+std::ofstream* cxlsim_c::get_output_stream(const std::string& filename) {
+  std::string fullpath = *m_knobs->KNOB_STATISTICS_OUT_DIRECTORY;
+  fullpath = fullpath + "/" + filename;
+
+  // stat name already encountered
+  // check if the output stream is opened then do nothing
+  // otherwise open the stream
+  std::map<std::string, std::ofstream*>::iterator iter =
+    m_AllStatsOutputStreams.find(filename);
+
+  std::ofstream* stream = NULL;
+
+  // first time this filename is encounterd
+  // create the std::ofstream object
+  if (iter == m_AllStatsOutputStreams.end()) {
+    stream = new std::ofstream();
+    stream->exceptions(std::ofstream::eofbit | std::ofstream::failbit | std::ofstream::badbit);
+
+    try {
+      stream->open(fullpath.c_str(), std::ios_base::out);
+
+      if (stream->is_open())
+        m_AllStatsOutputStreams[filename] = stream;
+      else {
+        delete stream;
+        stream = NULL;
+      }
+    } catch (const std::ofstream::failure& exp) {
+      std::string strException = exp.what();
+      std::cout << strException;
+      delete stream;
+      stream = NULL;
+    }
+  } else {
+    stream = m_AllStatsOutputStreams[filename];
+  }
+
+  return stream;
+}
+
 void cxlsim_c::print() {
-  m_rc->print_rc_info();
-  m_mxp->print_cxlt3_info();
+  for (auto rc : m_rcs) {
+    rc->print_rc_info();
+  }
+  if (m_switch) {
+    m_switch->print_switch_info();
+  }
+  for (auto mxp : m_mxps) {
+    mxp->print_cxlt3_info();
+  }
 }
 
 } // namespace CXL
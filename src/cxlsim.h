@@ -39,19 +39,30 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <string>
 #include <map>
+#include <list>
+#include <vector>
+#include <cstdint>
+#include <functional>
 
 #include "Callback.h"
 #include "global_defs.h"
 #include "global_types.h"
+#include "clock_domain.h"
 
 namespace cxlsim {
 
 // outer simulator callback function
 typedef CallbackBase<void, Addr, bool, Counter, void*> callback_t;
 
+// checkpoint tag of an outer simulator request pointer & its inverse
+typedef std::function<uint64_t(void*)> ckpt_save_tag_t;
+typedef std::function<void*(uint64_t)> ckpt_load_tag_t;
+
+// clock domains, in the order their simultaneous edges are run. the io
+// domain is the external clock (run_a_cycle)
 typedef enum CLOCK_DOMAIN {
-  CLOCK_IO = 0,
-  CLOCK_CXLRAM,
+  CLOCK_IO = 0, /**< root complexes, switch, links & device controllers (clock_io) */
+  CLOCK_CXLRAM, /**< dram of the memory expanders (clock_cxlram) */
   CLOCK_DOMAIN_COUNT
 } CLOCK_DOMAIN;
 
@@ -79,15 +90,31 @@ public:
 
   /** 
    * callback function register
+   * - each host (root complex) may have its own callback, hosts without
+   *   one use the callback of host 0
+  */
+  void register_callback(callback_t* fn, int host = 0);
+
+  /** 
+   * early completion callback function register
+   * - called when the critical chunk of a read response arrives
+   *   (pcie_critical_chunk_first), before the full cacheline is in
   */
-  void register_callback(callback_t* fn);
+  void register_early_callback(callback_t* fn);
+
+  /**
+   * number of requests the outer simulator will insert
+   * - used for the eta of the progress line (progress_print_period)
+   */
+  void set_total_reqs(Counter total);
 
   /**
    * insert a request to the CXL mem 
    * - it can take a arbitrary pointer type of the outer simulator (void* req)
    *   and return it by the registered callback function
+   * - host selects the root complex (num_hosts)
    */
-  Counter insert_request(Addr addr, bool write, void* req);
+  Counter insert_request(Addr addr, bool write, void* req, int host = 0);
 
   /**
    * Tick a cycle
@@ -101,6 +128,44 @@ public:
 
   void print();
 
+  /**
+   * Output stream of a stat file in the stat directory (NULL on failure)
+   */
+  std::ofstream* get_output_stream(const std::string& filename);
+
+  /**
+   * checkpoint tags of the outer simulator request pointers (void* req)
+   * - without them the pointer value itself is kept, which is valid only
+   *   when restoring in the same process (e.g. after fork)
+   */
+  void register_checkpoint_tags(ckpt_save_tag_t save_tag, ckpt_load_tag_t load_tag);
+
+  /**
+   * No request is inside the dram of any mxp. ramulator state is not
+   * checkpointed, so checkpoints are taken only at such cycles
+   */
+  bool checkpoint_ready();
+
+  /**
+   * Save the simulator state to a binary checkpoint
+   * - outer : writes the state of the outer simulator into the same file
+   */
+  bool save_checkpoint(const std::string& path, 
+                       std::function<void(checkpoint_c*)> outer = nullptr);
+
+  /**
+   * Restore the simulator state (after init, before the first cycle)
+   * - outer : reads back what outer wrote when saving
+   */
+  bool load_checkpoint(const std::string& path,
+                       std::function<void(checkpoint_c*)> outer = nullptr);
+
+  /**
+   * Sampling (sample_period) reached its target error, the outer simulator
+   * may stop
+   */
+  bool sampling_done();
+
   ////////////////////////////////////////////////////////////////////////////
 
 private:
@@ -118,17 +183,84 @@ private:
    */
   void request_done(cxl_req_s* req);
 
+  /* 
+   * Called when the critical chunk of a read returns to the RC, internally
+   * calls the registered early callback function
+   */
+  void request_early_done(cxl_req_s* req);
+
+  /*
+   * Call the callbacks of requests completed by the functional fast-forward
+   */
+  void functional_done();
+
+  /*
+   * Run the components of a clock domain for one of its cycles
+   */
+  void run_domain(int domain, bool pll_locked, bool detailed);
+
+  /*
+   * Fill latency percentile stats from the latency histograms
+   */
+  void save_latency_stats();
+
+  /*
+   * Dump the latency histograms (after the stat directory is created)
+   */
+  void save_latency_hist();
+
+  /*
+   * Dump bandwidth & latency of each host (multi-host only)
+   */
+  void save_host_stats();
+
+  /*
+   * Endpoints of every link, the m2s side first (link order of
+   * pcie_link_overrides)
+   */
+  std::vector<pcie_ep_c*> get_link_endpoints();
+
+  /*
+   * Fill the link energy stats & dump the power of each link direction
+   */
+  void save_link_energy();
+  void save_link_stats();
+
+  /*
+   * Fill the energy stats of the controllers, the drams & the total, and
+   * dump the energy of each component (after the link energy)
+   */
+  void save_energy();
+  void save_energy_stats();
+
+  /*
+   * Save or restore the state of all simulation objects
+   */
+  void checkpoint(checkpoint_c* ckpt);
+
 public:
-  pcie_rc_c* m_rc; /**< Root Complex */
-  cxlt3_c* m_mxp; /**< MXP */
+  pcie_rc_c* m_rc; /**< Root Complex of host 0 */
+  std::vector<pcie_rc_c*> m_rcs; /**< Root Complex of each host */
+  int m_num_hosts; /**< number of hosts */
+  cxlt3_c* m_mxp; /**< MXP (first one behind a switch) */
+  std::vector<cxlt3_c*> m_mxps; /**< all MXPs */
+  cxl_switch_c* m_switch; /**< switch between the RCs & MXPs (NULL : direct links) */
   Counter m_cycle; /**< External clock */
 
   KnobsContainer* m_knobsContainer;
   all_knobs_c* m_knobs; /**< all_knobs */
+  knob_config_s* m_cfg; /**< knob values snapshotted after init_knobs */
 
   all_stats_c *m_allStats; /**< all_stats*/
+  uint64_t* m_stat_counters; /**< flat stat counters, owned by m_allStats */
   ProcessorStatistics* m_ProcessorStats;
+  trace_event_c* m_trace; /**< trace-event writer */
+  sim_profile_c* m_profile; /**< self-profiling & progress */
+  sampler_c* m_sampler; /**< statistical sampling */
   CoreStatistics* m_coreStatsTemplate;
+  int m_msg_uid; /**< last message id */
+  int m_slot_uid; /**< last slot id */
+  int m_flit_uid; /**< last flit id */
   std::map<std::string, std::ofstream *> m_AllStatsOutputStreams;
 
 private:
@@ -137,15 +269,22 @@ private:
   pool_c<slot_s>* m_slot_pool; /**< memory pool for slots */
   pool_c<flit_s>* m_flit_pool; /**< memory pool for flits */
 
-  static Counter m_req_id;
+  Counter m_req_id; /**< last request id */
+  Counter m_inflight_reqs; /**< requests inside the detailed model */
+  std::list<cxl_req_s*> m_functional_q; /**< fast-forwarded requests to call back */
+
+  std::vector<callback_t*> m_trans_done_cb; /* callback function of each host */
+  latency_hist_c* m_read_lat_hist; /**< end-to-end read latency */
+  latency_hist_c* m_write_lat_hist; /**< end-to-end write latency */
+  std::vector<latency_hist_c*> m_host_read_hist; /**< read latency per host */
+  std::vector<latency_hist_c*> m_host_write_hist; /**< write latency per host */
+  interval_stat_c* m_interval_stat; /**< time-series stats */
 
-  callback_t* m_trans_done_cb; /* callback function for the outer simultor */
+  callback_t* m_early_done_cb; /* early completion callback for the outer simulator */
+  ckpt_save_tag_t m_ckpt_save_tag; /**< request pointer -> checkpoint tag */
+  ckpt_load_tag_t m_ckpt_load_tag; /**< checkpoint tag -> request pointer */
 
-  int m_clock_lcm;    /**< lcm of clock domains */
-  int *m_domain_freq;
-  int *m_domain_count;
-  int *m_domain_next;
-  int m_clock_internal; /**<< internal clock of simulator */
+  clock_domain_c m_clocks[CLOCK_DOMAIN_COUNT]; /**< clock domains (picosecond timebase) */
 };
 
 }
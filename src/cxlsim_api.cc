@@ -0,0 +1,199 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : cxlsim_api.cc
+ * Description  : C API of the shared library (libcxlsim.so) for host simulators
+ *********************************************************************************************/
+
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cxlsim_api.h"
+#include "cxlsim.h"
+#include "statistics.h"
+
+using namespace cxlsim;
+
+/**
+ * Completion port of a host : the callbacks carry no host id, so each host
+ * gets its own consumer object
+ */
+struct cxlsim_port_s {
+  cxlsim_handle_s* m_handle; /**< owning instance */
+  int m_host; /**< host id */
+  callback_t* m_callback; /**< callback registered to cxlsim */
+
+  void request_done(Addr addr, bool write, Counter id, void* req);
+};
+
+/**
+ * Simulator instance behind cxlsim_t
+ */
+struct cxlsim_handle_s {
+  cxlsim_c* m_sim; /**< simulator */
+  std::vector<cxlsim_port_s*> m_ports; /**< completion port of each host */
+  std::deque<cxlsim_done_t> m_done_q; /**< completions not polled yet */
+};
+
+void cxlsim_port_s::request_done(Addr addr, bool write, Counter id, void* req) {
+  cxlsim_done_t done;
+  done.addr = addr;
+  done.tag = (uint64_t)(uintptr_t)req;
+  done.id = id;
+  done.write = write;
+  done.host = m_host;
+  m_handle->m_done_q.push_back(done);
+}
+
+int cxlsim_api_version(void) {
+  return CXLSIM_API_VERSION;
+}
+
+cxlsim_t* cxlsim_create(const char* const* keys, const char* const* values, size_t count) {
+  // key/value pairs are handed to the knob parser as --key=value
+  std::vector<std::string> args;
+  args.push_back("cxlsim");
+  for (size_t ii = 0; ii < count; ++ii) {
+    if (keys[ii] == NULL || values[ii] == NULL) {
+      return NULL;
+    }
+    args.push_back(std::string("--") + keys[ii] + "=" + values[ii]);
+  }
+
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(&arg[0]);
+  }
+  argv.push_back(NULL);
+
+  // no exception may cross the C boundary
+  cxlsim_handle_s* handle = new cxlsim_handle_s;
+  handle->m_sim = NULL;
+  try {
+    handle->m_sim = new cxlsim_c();
+    handle->m_sim->init((int)args.size(), argv.data());
+
+    for (int ii = 0; ii < handle->m_sim->m_num_hosts; ++ii) {
+      cxlsim_port_s* port = new cxlsim_port_s;
+      port->m_handle = handle;
+      port->m_host = ii;
+      port->m_callback = 
+        new Callback<cxlsim_port_s, void, Addr, bool, Counter, void*>
+                    (port, &cxlsim_port_s::request_done);
+      handle->m_ports.push_back(port);
+      handle->m_sim->register_callback(port->m_callback, ii);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "cxlsim_create: " << e.what() << std::endl;
+    cxlsim_destroy(handle);
+    return NULL;
+  }
+
+  return handle;
+}
+
+void cxlsim_destroy(cxlsim_t* sim) {
+  if (sim == NULL) {
+    return;
+  }
+
+  delete sim->m_sim;
+  for (auto port : sim->m_ports) {
+    delete port->m_callback;
+    delete port;
+  }
+  delete sim;
+}
+
+void cxlsim_tick(cxlsim_t* sim, uint64_t cycles) {
+  for (uint64_t ii = 0; ii < cycles; ++ii) {
+    sim->m_sim->run_a_cycle(false);
+  }
+}
+
+uint64_t cxlsim_cycle(const cxlsim_t* sim) {
+  return sim->m_sim->m_cycle;
+}
+
+size_t cxlsim_submit(cxlsim_t* sim, const cxlsim_req_t* reqs, size_t count) {
+  size_t accepted = 0;
+  for (; accepted < count; ++accepted) {
+    const cxlsim_req_t& req = reqs[accepted];
+    if (req.host < 0 || req.host >= sim->m_sim->m_num_hosts) {
+      break;
+    }
+    // the tag travels as the outer request pointer
+    if (sim->m_sim->insert_request(req.addr, req.write != 0,
+                                   (void*)(uintptr_t)req.tag, req.host) == 0) {
+      break;
+    }
+  }
+  return accepted;
+}
+
+size_t cxlsim_poll(cxlsim_t* sim, cxlsim_done_t* done, size_t max) {
+  size_t count = 0;
+  while (count < max && !sim->m_done_q.empty()) {
+    done[count++] = sim->m_done_q.front();
+    sim->m_done_q.pop_front();
+  }
+  return count;
+}
+
+size_t cxlsim_stat_count(const cxlsim_t* sim) {
+  return sim->m_sim->m_ProcessorStats->globalStats()->size();
+}
+
+const char* cxlsim_stat_name(const cxlsim_t* sim, size_t index) {
+  GlobalStatistics* stats = sim->m_sim->m_ProcessorStats->globalStats();
+  if (index >= (size_t)stats->size()) {
+    return NULL;
+  }
+  return (*stats)[index].getName().c_str();
+}
+
+int cxlsim_stat(const cxlsim_t* sim, const char* name, uint64_t* value) {
+  GlobalStatistics* stats = sim->m_sim->m_ProcessorStats->globalStats();
+  for (int ii = 0; ii < stats->size(); ++ii) {
+    AbstractStat& stat = (*stats)[ii];
+    if (stat.getName() == name) {
+      // counters live in the flat array until the final dump
+      *value = sim->m_sim->m_stat_counters[stat.getID()];
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void cxlsim_finalize(cxlsim_t* sim) {
+  sim->m_sim->finalize();
+}
@@ -0,0 +1,161 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : cxlsim_api.h
+ * Description  : C API of the shared library (libcxlsim.so) for host simulators
+ *********************************************************************************************/
+
+#ifndef CXLSIM_API_H
+#define CXLSIM_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Only this header is needed to embed the simulator : no STL type, knob or
+ * stat class crosses the boundary, and the shared library exports nothing
+ * but the functions below.
+ *
+ *   const char* keys[] = {"num_hosts", "out"};
+ *   const char* values[] = {"2", "run0"};
+ *   cxlsim_t* sim = cxlsim_create(keys, values, 2);
+ *   cxlsim_submit(sim, reqs, n);
+ *   cxlsim_tick(sim, 100);
+ *   n = cxlsim_poll(sim, done, 64);
+ *   cxlsim_finalize(sim);
+ *   cxlsim_destroy(sim);
+ */
+
+#define CXLSIM_API_VERSION 1 /**< bumped on incompatible changes */
+
+#if defined(__GNUC__)
+#define CXLSIM_API __attribute__((visibility("default")))
+#else
+#define CXLSIM_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cxlsim_handle_s cxlsim_t; /**< opaque simulator instance */
+
+/**
+ * Request submitted by the host
+ */
+typedef struct cxlsim_req_s {
+  uint64_t addr; /**< address */
+  uint64_t tag; /**< host tag, returned with the completion */
+  int32_t write; /**< 0 : read, otherwise write */
+  int32_t host; /**< host (root complex) id, < num_hosts */
+} cxlsim_req_t;
+
+/**
+ * Completed request
+ */
+typedef struct cxlsim_done_s {
+  uint64_t addr; /**< address */
+  uint64_t tag; /**< tag given at submit */
+  uint64_t id; /**< request id returned by the simulator */
+  int32_t write; /**< 0 : read, otherwise write */
+  int32_t host; /**< host (root complex) id */
+} cxlsim_done_t;
+
+/**
+ * Version of this header the library was built with (CXLSIM_API_VERSION)
+ */
+CXLSIM_API int cxlsim_api_version(void);
+
+/**
+ * Create & initialize a simulator
+ * - keys/values : knob name & value pairs, same as --key=value on the
+ *   command line (e.g. "num_hosts", "2"). cxl_params.in is applied first
+ * - returns NULL if the initialization throws (e.g. out of memory). As on
+ *   the command line, an unknown knob is only reported, and a knob value
+ *   failing a check (ASSERTM) aborts the process : validate the values
+ *   beforehand when the host cannot afford to exit
+ */
+CXLSIM_API cxlsim_t* cxlsim_create(const char* const* keys, const char* const* values,
+                                   size_t count);
+
+/**
+ * Destroy a simulator (call cxlsim_finalize first to dump the stats)
+ */
+CXLSIM_API void cxlsim_destroy(cxlsim_t* sim);
+
+/**
+ * Tick cycles of the external clock
+ */
+CXLSIM_API void cxlsim_tick(cxlsim_t* sim, uint64_t cycles);
+
+/**
+ * Current cycle of the external clock
+ */
+CXLSIM_API uint64_t cxlsim_cycle(const cxlsim_t* sim);
+
+/**
+ * Submit requests in order
+ * - returns the number accepted; submission stops at the first request a
+ *   full root complex refuses, the host retries the rest after a tick
+ */
+CXLSIM_API size_t cxlsim_submit(cxlsim_t* sim, const cxlsim_req_t* reqs, size_t count);
+
+/**
+ * Copy up to max completed requests in completion order
+ * - returns the number copied, the rest stay for the next poll
+ */
+CXLSIM_API size_t cxlsim_poll(cxlsim_t* sim, cxlsim_done_t* done, size_t max);
+
+/**
+ * Number of global stats (io.stat.def)
+ */
+CXLSIM_API size_t cxlsim_stat_count(const cxlsim_t* sim);
+
+/**
+ * Name of the index-th global stat (NULL when out of range), valid until
+ * cxlsim_destroy
+ */
+CXLSIM_API const char* cxlsim_stat_name(const cxlsim_t* sim, size_t index);
+
+/**
+ * Current counter of a global stat by name
+ * - returns 0 and sets *value on success, -1 when there is no such stat
+ */
+CXLSIM_API int cxlsim_stat(const cxlsim_t* sim, const char* name, uint64_t* value);
+
+/**
+ * Finish the simulation & write the stat files (stat directory : "out" knob)
+ */
+CXLSIM_API void cxlsim_finalize(cxlsim_t* sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CXLSIM_API_H
@@ -11,7 +11,19 @@ class all_stats_c;
 class pcie_ep_c;
 class pcie_rc_c;
 class cxlt3_c;
+class cxl_switch_c;
 class vc_buff_c;
+class mxp_prefetcher_c;
+class latency_hist_c;
+class interval_stat_c;
+class trace_event_c;
+class sim_profile_c;
+class checkpoint_c;
+class sampler_c;
+class traffic_gen_c;
+class loaded_lat_c;
+class lockstep_c;
+class shm_frontend_c;
 
 class KnobsContainer;
 class ProcessorStatistics;
@@ -26,6 +38,7 @@ typedef struct cxl_req_s cxl_req_s;
 typedef struct message_s message_s;
 typedef struct slot_s slot_s;
 typedef struct flit_s flit_s;
+typedef struct knob_config_s knob_config_s;
 
 } // namespace CXL
 
@@ -0,0 +1,178 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : interval_stat.cc
+ * Description  : Periodic time-series statistics
+ *********************************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <sys/stat.h>
+
+#include "interval_stat.h"
+#include "latency_hist.h"
+#include "checkpoint.h"
+#include "cxlsim.h"
+#include "pcie_rc.h"
+#include "cxl_t3.h"
+
+#include "all_knobs.h"
+#include "statistics.h"
+
+namespace cxlsim {
+
+interval_stat_c::interval_stat_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  m_interval = CFG(KNOB_STAT_INTERVAL);
+  m_freq = CFG(KNOB_CLOCK_IO);
+  m_cycle = 0;
+  m_interval_cycle = 0;
+  m_stream = NULL;
+
+  m_read_hist = new latency_hist_c(CFG(KNOB_LATENCY_HIST_SUB_BITS));
+  m_write_hist = new latency_hist_c(CFG(KNOB_LATENCY_HIST_SUB_BITS));
+
+  m_prev_m2s_bits = 0;
+  m_prev_s2m_bits = 0;
+  m_rc_pendq_sum = 0;
+  m_mxp_pendq_sum = 0;
+  m_dram_pendq_sum = 0;
+
+  if (!enabled()) {
+    return;
+  }
+
+  // the stat directory is otherwise created only at the final stat dump
+  std::string stat_path = *KNOB(KNOB_STATISTICS_OUT_DIRECTORY);
+  mkdir(stat_path.c_str(), S_IRWXU);
+
+  m_stream = m_simBase->get_output_stream("interval.csv");
+  if (m_stream != NULL) {
+    *m_stream << "cycle,m2s_gbps,s2m_gbps,rd_done,wr_done,"
+              << "rd_avg,rd_p50,rd_p99,wr_avg,wr_p50,wr_p99,"
+              << "rc_pendq,mxp_pendq,dram_pendq" << std::endl;
+  }
+}
+
+interval_stat_c::~interval_stat_c() {
+  delete m_read_hist;
+  delete m_write_hist;
+}
+
+bool interval_stat_c::enabled() {
+  return m_interval > 0;
+}
+
+void interval_stat_c::record_latency(bool write, Counter latency) {
+  if (write) {
+    m_write_hist->record(latency);
+  } else {
+    m_read_hist->record(latency);
+  }
+}
+
+void interval_stat_c::run_a_cycle() {
+  for (auto rc : m_simBase->m_rcs) {
+    m_rc_pendq_sum += rc->pending_size();
+  }
+  for (auto mxp : m_simBase->m_mxps) {
+    m_mxp_pendq_sum += mxp->pending_size();
+    m_dram_pendq_sum += mxp->dram_pending_size();
+  }
+
+  m_cycle++;
+  m_interval_cycle++;
+  if (m_interval_cycle == (Counter)m_interval) {
+    dump();
+  }
+}
+
+void interval_stat_c::finalize() {
+  if (enabled() && m_interval_cycle > 0) {
+    dump();
+  }
+}
+
+void interval_stat_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_cycle);
+  ckpt->io(m_interval_cycle);
+  ckpt->io(m_prev_m2s_bits);
+  ckpt->io(m_prev_s2m_bits);
+  ckpt->io(m_rc_pendq_sum);
+  ckpt->io(m_mxp_pendq_sum);
+  ckpt->io(m_dram_pendq_sum);
+  m_read_hist->checkpoint(ckpt);
+  m_write_hist->checkpoint(ckpt);
+}
+
+void interval_stat_c::dump() {
+  // summed over the links of all hosts
+  Counter m2s_bits = 0;
+  Counter s2m_bits = 0;
+  for (auto rc : m_simBase->m_rcs) {
+    m2s_bits += rc->m_txphys_bits;
+    s2m_bits += rc->m_peer_ep->m_txphys_bits;
+  }
+
+  // bits per io cycle * cycles per ns = Gb/s
+  double cycles = static_cast<double>(m_interval_cycle);
+  double m2s_gbps = (m2s_bits - m_prev_m2s_bits) * m_freq / cycles;
+  double s2m_gbps = (s2m_bits - m_prev_s2m_bits) * m_freq / cycles;
+  double rd_avg = m_read_hist->count() ? 
+                  1.0 * m_read_hist->sum() / m_read_hist->count() : 0.0;
+  double wr_avg = m_write_hist->count() ? 
+                  1.0 * m_write_hist->sum() / m_write_hist->count() : 0.0;
+
+  if (m_stream != NULL) {
+    std::ofstream& out = *m_stream;
+    out << std::fixed << std::setprecision(2)
+        << m_cycle << ","
+        << m2s_gbps << "," << s2m_gbps << ","
+        << m_read_hist->count() << "," << m_write_hist->count() << ","
+        << rd_avg << "," << m_read_hist->percentile(50.0) << ","
+        << m_read_hist->percentile(99.0) << ","
+        << wr_avg << "," << m_write_hist->percentile(50.0) << ","
+        << m_write_hist->percentile(99.0) << ","
+        << m_rc_pendq_sum / cycles << ","
+        << m_mxp_pendq_sum / cycles << ","
+        << m_dram_pendq_sum / cycles << std::endl;
+  }
+
+  // reset interval counters
+  m_interval_cycle = 0;
+  m_prev_m2s_bits = m2s_bits;
+  m_prev_s2m_bits = s2m_bits;
+  m_rc_pendq_sum = 0;
+  m_mxp_pendq_sum = 0;
+  m_dram_pendq_sum = 0;
+  m_read_hist->reset();
+  m_write_hist->reset();
+}
+
+} // namespace CXL
@@ -0,0 +1,110 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : interval_stat.h
+ * Description  : Periodic time-series statistics
+ *********************************************************************************************/
+
+#ifndef INTERVAL_STAT_H
+#define INTERVAL_STAT_H
+
+#include <fstream>
+
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+// dumps one csv row every stat_interval io cycles : link payload bandwidth
+// per direction, completed requests, latency & average queue occupancies
+// of the interval
+class interval_stat_c {
+public:
+  /**
+   * Constructor
+   */
+  interval_stat_c(cxlsim_c* simBase);
+
+  /**
+   * Destructor
+   */
+  ~interval_stat_c();
+
+  /**
+   * Returns true if interval stats are enabled
+   */
+  bool enabled();
+
+  /**
+   * Record end-to-end latency of a finished request
+   */
+  void record_latency(bool write, Counter latency);
+
+  /**
+   * Tick a io cycle : sample queues & dump at the end of an interval
+   */
+  void run_a_cycle();
+
+  /**
+   * Dump the last (partial) interval
+   */
+  void finalize();
+
+  /**
+   * Save or restore the counters of the current interval
+   */
+  void checkpoint(checkpoint_c* ckpt);
+
+private:
+  interval_stat_c(); // do not implement
+
+  void dump(); /**< write a row & reset interval counters */
+
+private:
+  int m_interval; /**< interval length in io cycles (0 : disabled) */
+  float m_freq; /**< io clock frequency in GHz */
+  Counter m_cycle; /**< io cycle */
+  Counter m_interval_cycle; /**< cycles in the current interval */
+  std::ofstream* m_stream; /**< csv output */
+
+  latency_hist_c* m_read_hist; /**< read latency of the interval */
+  latency_hist_c* m_write_hist; /**< write latency of the interval */
+
+  Counter m_prev_m2s_bits; /**< rc tx bits at the start of the interval */
+  Counter m_prev_s2m_bits; /**< mxp tx bits at the start of the interval */
+  Counter m_rc_pendq_sum; /**< sum of rc pending queue sizes */
+  Counter m_mxp_pendq_sum; /**< sum of mxp pending queue sizes */
+  Counter m_dram_pendq_sum; /**< sum of dram pending requests */
+
+  cxlsim_c* m_simBase;
+};
+
+} // namespace CXL
+
+#endif // INTERVAL_STAT_H
@@ -0,0 +1,152 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : latency_hist.cc
+ * Description  : Log-bucketed latency histogram
+ *********************************************************************************************/
+
+#include <cmath>
+#include <iomanip>
+#include <algorithm>
+
+#include "latency_hist.h"
+#include "checkpoint.h"
+
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+latency_hist_c::latency_hist_c(int sub_bits) {
+  ASSERTM(sub_bits > 0 && sub_bits < 16, "latency histogram sub_bits out of range\n");
+  m_sub_bits = sub_bits;
+  m_sub_count = 1 << sub_bits;
+  m_count = 0;
+  m_sum = 0;
+  m_max = 0;
+}
+
+void latency_hist_c::record(Counter value) {
+  int index = get_bucket(value);
+  if (index >= (int)m_buckets.size()) {
+    m_buckets.resize(index + 1, 0);
+  }
+  m_buckets[index]++;
+
+  m_count++;
+  m_sum += value;
+  m_max = std::max(m_max, value);
+}
+
+void latency_hist_c::reset() {
+  m_buckets.clear();
+  m_count = 0;
+  m_sum = 0;
+  m_max = 0;
+}
+
+Counter latency_hist_c::percentile(double p) {
+  if (m_count == 0) {
+    return 0;
+  }
+
+  Counter target = static_cast<Counter>(std::ceil(p / 100.0 * m_count));
+  target = std::max(target, (Counter)1);
+
+  Counter cumulative = 0;
+  for (int ii = 0; ii < (int)m_buckets.size(); ii++) {
+    cumulative += m_buckets[ii];
+    if (cumulative >= target) {
+      return std::min(get_bucket_high(ii), m_max);
+    }
+  }
+  return m_max;
+}
+
+void latency_hist_c::print(std::ofstream& out, const std::string& name) {
+  out << name << " (count: " << m_count << ", max: " << m_max << ")" << std::endl;
+
+  Counter cumulative = 0;
+  for (int ii = 0; ii < (int)m_buckets.size(); ii++) {
+    if (m_buckets[ii] == 0) {
+      continue;
+    }
+    cumulative += m_buckets[ii];
+
+    out << std::setw(12) << get_bucket_low(ii) << " - " 
+        << std::setw(12) << std::left << get_bucket_high(ii) << std::right
+        << std::setw(12) << m_buckets[ii]
+        << std::setw(12) << std::fixed << std::setprecision(4)
+        << 100.0 * cumulative / m_count << std::endl;
+  }
+  out << std::endl;
+}
+
+void latency_hist_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_buckets);
+  ckpt->io(m_count);
+  ckpt->io(m_sum);
+  ckpt->io(m_max);
+}
+
+// values below 2^sub_bits get a bucket each. above, the msb selects the
+// power of two range and the next sub_bits bits the bucket within it
+int latency_hist_c::get_bucket(Counter value) {
+  if (value < (Counter)m_sub_count) {
+    return static_cast<int>(value);
+  }
+
+  int msb = 0;
+  while ((value >> (msb + 1)) != 0) {
+    msb++;
+  }
+
+  int shift = msb - m_sub_bits;
+  return m_sub_count * (shift + 1) + 
+         static_cast<int>((value >> shift) & (m_sub_count - 1));
+}
+
+Counter latency_hist_c::get_bucket_low(int index) {
+  if (index < m_sub_count) {
+    return index;
+  }
+
+  int shift = index / m_sub_count - 1;
+  return static_cast<Counter>(m_sub_count + index % m_sub_count) << shift;
+}
+
+Counter latency_hist_c::get_bucket_high(int index) {
+  if (index < m_sub_count) {
+    return index;
+  }
+
+  int shift = index / m_sub_count - 1;
+  return get_bucket_low(index) + ((Counter)1 << shift) - 1;
+}
+
+} // namespace CXL
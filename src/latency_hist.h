@@ -0,0 +1,103 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : latency_hist.h
+ * Description  : Log-bucketed latency histogram
+ *********************************************************************************************/
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+// HDR-style histogram : each power of two range is split into 2^sub_bits
+// linear buckets, so a bucket is within 1/2^sub_bits of the values it holds
+class latency_hist_c {
+public:
+  /**
+   * Constructor
+   */
+  latency_hist_c(int sub_bits);
+
+  /**
+   * Record a latency
+   */
+  void record(Counter value);
+
+  /**
+   * Clear all recorded values
+   */
+  void reset();
+
+  /**
+   * Latency at percentile p (0 < p <= 100). Reports the upper bound of
+   * the bucket, clamped to the maximum recorded latency
+   */
+  Counter percentile(double p);
+
+  Counter count() { return m_count; }
+  Counter sum() { return m_sum; }
+  Counter max() { return m_max; }
+
+  /**
+   * Dump non-empty buckets
+   */
+  void print(std::ofstream& out, const std::string& name);
+
+  /**
+   * Save or restore the buckets
+   */
+  void checkpoint(checkpoint_c* ckpt);
+
+private:
+  latency_hist_c(); // do not implement
+
+  int get_bucket(Counter value); /**< bucket index of a value */
+  Counter get_bucket_low(int index); /**< smallest value of a bucket */
+  Counter get_bucket_high(int index); /**< largest value of a bucket */
+
+private:
+  int m_sub_bits; /**< log2 of buckets per power of two */
+  int m_sub_count; /**< buckets per power of two */
+  std::vector<Counter> m_buckets; /**< bucket counts */
+  Counter m_count; /**< number of recorded values */
+  Counter m_sum; /**< sum of recorded values */
+  Counter m_max; /**< maximum recorded value */
+};
+
+} // namespace CXL
+
+#endif // LATENCY_HIST_H
@@ -0,0 +1,263 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : loaded_lat.cc
+ * Description  : Loaded latency harness (latency probe under swept bandwidth injection)
+ *********************************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sys/stat.h>
+
+#include "all_knobs.h"
+#include "cxlsim.h"
+#include "loaded_lat.h"
+#include "latency_hist.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+loaded_lat_c::loaded_lat_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  m_cycle = 0;
+  m_num_points = CFG(KNOB_LOADED_LAT_POINTS);
+  m_max_rate = CFG(KNOB_LOADED_LAT_MAX_RATE);
+  m_warmup = CFG(KNOB_LOADED_LAT_WARMUP);
+  m_window = CFG(KNOB_LOADED_LAT_WINDOW);
+  m_knee_factor = CFG(KNOB_LOADED_LAT_KNEE_FACTOR);
+  m_read_ratio = CFG(KNOB_LOADED_LAT_READ_RATIO);
+  m_freq = CFG(KNOB_CLOCK_IO);
+  m_line_size = CFG(KNOB_RAMULATOR_CACHELINE_SIZE);
+  m_lines = CFG(KNOB_TRAFFIC_FOOTPRINT) / m_line_size;
+  m_base = CFG(KNOB_TRAFFIC_BASE_ADDR);
+  m_rate = 0.0;
+  m_measuring = false;
+  m_rng.seed(CFG(KNOB_TRAFFIC_SEED));
+  m_probe_hist = new latency_hist_c(CFG(KNOB_LATENCY_HIST_SUB_BITS));
+
+  int num_injectors = CFG(KNOB_LOADED_LAT_INJECTORS);
+  ASSERTM(m_num_points >= 2 && m_window > 0, "loaded_lat needs two points & a window\n");
+  ASSERTM((num_injectors > 0 && m_lines >= (Addr)num_injectors), 
+          "loaded_lat needs injectors & a footprint of a line per injector\n");
+
+  // probe on host 0, injectors spread over the hosts, each on its own slice
+  // of the footprint
+  Addr slice = m_lines / num_injectors * m_line_size;
+  m_streams.resize(num_injectors + 1);
+  for (int ii = 0; ii <= num_injectors; ++ii) {
+    ll_stream_s& stream = m_streams[ii];
+    stream.m_probe = (ii == 0);
+    stream.m_host = ii == 0 ? 0 : (ii - 1) % m_simBase->m_num_hosts;
+    stream.m_base = ii == 0 ? m_base : m_base + (ii - 1) * slice;
+    stream.m_cursor = 0;
+    stream.m_credit = 0.0;
+    stream.m_busy = false;
+    stream.m_issue_cycle = 0;
+    stream.m_done = 0;
+  }
+
+  // the request pointer handed to cxlsim is the stream
+  for (int ii = 0; ii < m_simBase->m_num_hosts; ++ii) {
+    callback_t *trans_callback = 
+      new Callback<loaded_lat_c, void, Addr, bool, Counter, void*>
+                  (&(*this), &loaded_lat_c::ll_callback);
+    m_simBase->register_callback(trans_callback, ii);
+  }
+}
+
+loaded_lat_c::~loaded_lat_c() {
+  delete m_probe_hist;
+}
+
+void loaded_lat_c::run_a_cycle(bool pll_locked) {
+  // the probe goes first so it never waits behind the injectors
+  for (auto& stream : m_streams) {
+    issue(&stream);
+  }
+
+  m_simBase->run_a_cycle(pll_locked);
+  m_cycle++;
+}
+
+void loaded_lat_c::run_sim() {
+  // past the first point the link & device cannot sustain, the injector
+  // backlog only grows & the probe latency says nothing about the expander
+  for (int ii = 0; ii < m_num_points; ++ii) {
+    run_point(ii);
+    if (!sustained(m_points.back())) {
+      break;
+    }
+  }
+  report();
+  std::cout << "Simulation ended" << std::endl;
+}
+
+void loaded_lat_c::run_point(int point) {
+  // injectors restart without the backlog of the previous point
+  m_rate = m_max_rate * point / (m_num_points - 1);
+  for (auto& stream : m_streams) {
+    stream.m_credit = 0.0;
+    stream.m_done = 0;
+  }
+
+  m_measuring = false;
+  for (int ii = 0; ii < m_warmup; ++ii) {
+    run_a_cycle(false);
+  }
+
+  m_measuring = true;
+  m_probe_hist->reset();
+  for (int ii = 0; ii < m_window; ++ii) {
+    run_a_cycle(false);
+  }
+  m_measuring = false;
+
+  // bytes per io cycle * cycles per ns = GB/s
+  // - only the injectors : the offered rate leaves out the probe
+  Counter done = 0;
+  for (auto& stream : m_streams) {
+    if (!stream.m_probe) {
+      done += stream.m_done;
+    }
+  }
+
+  ll_point_s result;
+  result.m_rate = m_rate;
+  result.m_offered_gbps = m_rate * m_line_size * m_freq;
+  result.m_achieved_gbps = 1.0 * done * m_line_size * m_freq / m_window;
+  result.m_probes = m_probe_hist->count();
+  result.m_lat_avg = result.m_probes ? 1.0 * m_probe_hist->sum() / result.m_probes / m_freq : 0.0;
+  result.m_lat_p50 = m_probe_hist->percentile(50.0) / m_freq;
+  result.m_lat_p99 = m_probe_hist->percentile(99.0) / m_freq;
+  m_points.push_back(result);
+
+  std::cout << std::fixed << std::setprecision(2) << "Loaded latency point " << point
+            << " : " << result.m_achieved_gbps << " GB/s, " << result.m_lat_avg 
+            << " ns" << std::endl;
+  std::cout.unsetf(std::ios_base::floatfield);
+}
+
+bool loaded_lat_c::sustained(const ll_point_s& point) {
+  return point.m_achieved_gbps >= LL_SUSTAINED_SHARE * point.m_offered_gbps;
+}
+
+void loaded_lat_c::issue(ll_stream_s* stream) {
+  void* req = static_cast<void*>(stream);
+
+  // pointer chase : the next read leaves once the previous one is back
+  if (stream->m_probe) {
+    if (!stream->m_busy) {
+      Addr addr = m_base + (m_rng.next() % m_lines) * m_line_size;
+      if (m_simBase->insert_request(addr, false, req, stream->m_host) != 0) {
+        stream->m_busy = true;
+        stream->m_issue_cycle = m_cycle;
+      }
+    }
+    return;
+  }
+
+  // injectors : sequential over their slice at an equal share of the rate
+  int num_injectors = m_streams.size() - 1;
+  Addr slice = m_lines / num_injectors * m_line_size;
+  stream->m_credit += m_rate / num_injectors;
+  while (stream->m_credit >= 1.0) {
+    Addr addr = stream->m_base + stream->m_cursor;
+    bool write = m_rng.uniform() >= m_read_ratio;
+    if (m_simBase->insert_request(addr, write, req, stream->m_host) == 0) {
+      return;
+    }
+    stream->m_cursor = (stream->m_cursor + m_line_size) % slice;
+    stream->m_credit -= 1.0;
+  }
+}
+
+void loaded_lat_c::report() {
+  // idle latency, knee (last point of the flat part) & peak sustained
+  // bandwidth
+  double idle = m_points[0].m_lat_avg;
+  int knee = 0;
+  int peak = 0;
+  for (int ii = 1; ii < (int)m_points.size(); ++ii) {
+    if (knee == ii - 1 && m_points[ii].m_lat_avg <= m_knee_factor * idle) {
+      knee = ii;
+    }
+    if (sustained(m_points[ii]) && 
+        m_points[ii].m_achieved_gbps > m_points[peak].m_achieved_gbps) {
+      peak = ii;
+    }
+  }
+
+  std::cout << std::fixed << std::setprecision(2) 
+            << "Idle latency : " << idle << " ns" << std::endl
+            << "Knee : " << m_points[knee].m_achieved_gbps << " GB/s at " 
+            << m_points[knee].m_lat_avg << " ns" << std::endl
+            << "Peak sustained bandwidth : " << m_points[peak].m_achieved_gbps << " GB/s at " 
+            << m_points[peak].m_lat_avg << " ns" << std::endl;
+  std::cout.unsetf(std::ios_base::floatfield);
+
+  // the stat directory is otherwise created only at the final stat dump
+  std::string stat_path = *KNOB(KNOB_STATISTICS_OUT_DIRECTORY);
+  mkdir(stat_path.c_str(), S_IRWXU);
+
+  std::ofstream* stream = m_simBase->get_output_stream("loaded_latency.csv");
+  if (stream == NULL) {
+    return;
+  }
+
+  std::ofstream& out = *stream;
+  out << "point,rate,offered_gbps,achieved_gbps,sustained,probes,"
+      << "lat_avg_ns,lat_p50_ns,lat_p99_ns" << std::endl;
+  for (int ii = 0; ii < (int)m_points.size(); ++ii) {
+    ll_point_s& point = m_points[ii];
+    out << std::fixed << std::setprecision(3) << ii << "," << point.m_rate << ","
+        << point.m_offered_gbps << "," << point.m_achieved_gbps << ","
+        << sustained(point) << "," << point.m_probes << "," << point.m_lat_avg << ","
+        << point.m_lat_p50 << "," << point.m_lat_p99 << std::endl;
+  }
+
+  out << std::endl << "idle_lat_ns,knee_gbps,knee_lat_ns,peak_gbps,peak_lat_ns" << std::endl;
+  out << idle << "," << m_points[knee].m_achieved_gbps << "," << m_points[knee].m_lat_avg
+      << "," << m_points[peak].m_achieved_gbps << "," << m_points[peak].m_lat_avg << std::endl;
+}
+
+void loaded_lat_c::ll_callback(Addr, bool, Counter, void *req) {
+  ll_stream_s* stream = static_cast<ll_stream_s*>(req);
+  if (m_measuring) {
+    stream->m_done++;
+  }
+
+  if (stream->m_probe) {
+    stream->m_busy = false;
+    if (m_measuring) {
+      m_probe_hist->record(m_cycle - stream->m_issue_cycle);
+    }
+  }
+}
+
+} // namespace CXL
@@ -0,0 +1,120 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : loaded_lat.h
+ * Description  : Loaded latency harness (latency probe under swept bandwidth injection)
+ *********************************************************************************************/
+
+#ifndef LOADED_LAT_H
+#define LOADED_LAT_H
+
+#include <string>
+#include <vector>
+
+#include "global_types.h"
+#include "global_defs.h"
+#include "traffic_gen.h"
+
+namespace cxlsim {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// a point is sustained if this share of the injected requests finishes
+#define LL_SUSTAINED_SHARE 0.95
+
+// request stream of the harness : the probe or a bandwidth injector
+typedef struct ll_stream_s {
+  bool m_probe; /**< pointer chase probe (one dependent read at a time) */
+  int m_host; /**< host (root complex) id */
+  Addr m_base; /**< injector : start of its buffer */
+  Addr m_cursor; /**< injector : offset of the next line */
+  double m_credit; /**< injector : requests allowed to issue */
+  bool m_busy; /**< probe : a read is in flight */
+  Counter m_issue_cycle; /**< probe : issue cycle of the read in flight */
+  Counter m_done; /**< requests finished in the current window */
+} ll_stream_s;
+
+// one point of the curve
+typedef struct ll_point_s {
+  double m_rate; /**< injection rate in requests per io cycle */
+  double m_offered_gbps; /**< injection rate in GB/s */
+  double m_achieved_gbps; /**< finished requests in GB/s */
+  Counter m_probes; /**< probe reads in the window */
+  double m_lat_avg; /**< probe latency in ns */
+  double m_lat_p50; /**< probe latency in ns */
+  double m_lat_p99; /**< probe latency in ns */
+} ll_point_s;
+
+// mlc-style loaded latency test : a pointer chase probe runs next to
+// bandwidth injectors whose total rate is swept from 0 (idle latency) to
+// loaded_lat_max_rate, giving the bandwidth-latency curve in one run. the
+// sweep stops after the first point the expander cannot sustain
+class loaded_lat_c {
+public:
+  loaded_lat_c(cxlsim_c* simBase);
+  ~loaded_lat_c();
+
+  void run_a_cycle(bool pll_locked);
+  void run_sim();
+
+private:
+  loaded_lat_c(); // do not implement
+
+  void ll_callback(Addr addr, bool write, Counter req_id, void *req);
+  void issue(ll_stream_s* stream);
+  void run_point(int point);
+  bool sustained(const ll_point_s& point);
+  void report();
+
+public:
+  cxlsim_c* m_simBase;
+  Counter m_cycle;
+
+private:
+  int m_num_points; /**< points of the sweep */
+  double m_max_rate; /**< injection rate of the last point */
+  int m_warmup; /**< io cycles before a window */
+  int m_window; /**< measured io cycles of a point */
+  float m_knee_factor; /**< knee : probe latency within this factor of idle */
+  float m_read_ratio; /**< share of injector reads */
+  float m_freq; /**< io clock frequency in GHz */
+  Addr m_line_size; /**< request size in bytes */
+  Addr m_lines; /**< probe footprint in cachelines */
+  Addr m_base; /**< lowest address */
+
+  double m_rate; /**< injection rate of the current point */
+  bool m_measuring; /**< the window of the current point is open */
+  traffic_rng_s m_rng; /**< probe addresses & injector read/write mix */
+  latency_hist_c* m_probe_hist; /**< probe latency of the window */
+  std::vector<ll_stream_s> m_streams; /**< probe first, then injectors */
+  std::vector<ll_point_s> m_points; /**< measured curve */
+};
+
+} //namespace CXL
+
+#endif //LOADED_LAT_H
@@ -0,0 +1,236 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : lockstep.cc
+ * Description  : Lockstep simulation of several configurations from one trace decode
+ *********************************************************************************************/
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "all_knobs.h"
+#include "cxlsim.h"
+#include "lockstep.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+lockstep_c::lockstep_c(cxlsim_c* simBase, int argc, char** argv) {
+  m_simBase = simBase;
+  m_trace_eof = false;
+  m_trace_base = 0;
+  m_epoch = CFG(KNOB_MULTI_EPOCH);
+  m_num_threads = CFG(KNOB_MULTI_THREADS);
+  ASSERTM(m_epoch > 0, "multi_epoch must be positive\n");
+
+  std::string config_file = *KNOB(KNOB_MULTI_CONFIG_FILE);
+  std::string out_dir = *KNOB(KNOB_STATISTICS_OUT_DIRECTORY);
+  std::ifstream file(config_file);
+  ASSERTM(file.is_open(), "cannot read multi_config_file\n");
+
+  // the stat directories of the simulators are created inside it
+  mkdir(out_dir.c_str(), S_IRWXU);
+
+  // one simulator per line : the knobs of the line come first so they win
+  // over the command line (the first value of a knob is kept)
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream tokens(line.substr(0, line.find('#')));
+    std::vector<std::string> args = {argv[0]};
+    std::string token;
+    while (tokens >> token) {
+      args.push_back(token.compare(0, 2, "--") == 0 ? token : "--" + token);
+    }
+    if (args.size() == 1) {
+      continue;
+    }
+    args.push_back("--out=" + out_dir + "/cfg" + std::to_string(m_lanes.size()));
+    for (int ii = 1; ii < argc; ++ii) {
+      args.push_back(argv[ii]);
+    }
+
+    std::vector<char*> sim_argv;
+    for (auto& arg : args) {
+      sim_argv.push_back(&arg[0]);
+    }
+
+    lockstep_lane_s lane;
+    lane.m_sim = new cxlsim_c();
+    lane.m_sim->init(sim_argv.size(), sim_argv.data());
+    lane.m_cycle = 0;
+    lane.m_pos = 0;
+    lane.m_returned = 0;
+    m_lanes.push_back(lane);
+  }
+  ASSERTM(!m_lanes.empty(), "multi_config_file has no configuration\n");
+
+  if (m_num_threads <= 0) {
+    m_num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_num_threads = std::min(m_num_threads, (int)m_lanes.size());
+
+  // the request pointer handed to a simulator is its lane
+  for (auto& lane : m_lanes) {
+    callback_t *trans_callback = 
+      new Callback<lockstep_c, void, Addr, bool, Counter, void*>
+                  (&(*this), &lockstep_c::lockstep_callback);
+    for (int ii = 0; ii < lane.m_sim->m_num_hosts; ++ii) {
+      lane.m_sim->register_callback(trans_callback, ii);
+    }
+  }
+}
+
+lockstep_c::~lockstep_c() {
+  for (auto& lane : m_lanes) {
+    delete lane.m_sim;
+  }
+}
+
+void lockstep_c::set_tracefile(std::string filename) {
+  m_tracefilename = filename;
+}
+
+void lockstep_c::run_sim() {
+  m_tracefile.open(m_tracefilename);
+  m_trace_eof = !m_tracefile.is_open();
+
+  Counter epoch_end = 0;
+  while (true) {
+    bool all_done = true;
+    for (auto& lane : m_lanes) {
+      all_done &= done(&lane);
+    }
+    if (all_done) {
+      break;
+    }
+
+    epoch_end += m_epoch;
+    decode(epoch_end);
+
+    // simulators share only the decoded requests, which stay untouched
+    // until every worker is back
+    std::vector<std::thread> workers;
+    for (int ii = 1; ii < m_num_threads; ++ii) {
+      workers.push_back(std::thread(&lockstep_c::run_epoch, this, ii, 
+                                    m_num_threads, epoch_end));
+    }
+    run_epoch(0, m_num_threads, epoch_end);
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    // drop requests every simulator has inserted
+    Counter min_pos = m_lanes[0].m_pos;
+    for (auto& lane : m_lanes) {
+      min_pos = std::min(min_pos, lane.m_pos);
+    }
+    while (m_trace_base < min_pos) {
+      m_trace.pop_front();
+      m_trace_base++;
+    }
+  }
+  m_tracefile.close();
+
+  for (int ii = 0; ii < (int)m_lanes.size(); ++ii) {
+    lockstep_lane_s& lane = m_lanes[ii];
+    lane.m_sim->finalize();
+    std::cout << "Configuration " << ii << " : " << lane.m_returned 
+              << " requests in " << lane.m_cycle << " cycles ("
+              << lane.m_sim->m_knobs->KNOB_STATISTICS_OUT_DIRECTORY->getValue() << ")" 
+              << std::endl;
+  }
+  std::cout << "Simulation ended" << std::endl;
+}
+
+void lockstep_c::decode(Counter epoch_end) {
+  // the last decoded request may belong to a later epoch
+  while (!m_trace_eof && (m_trace.empty() || m_trace.back().m_cycle < epoch_end)) {
+    std::string line;
+    if (!std::getline(m_tracefile, line)) {
+      m_trace_eof = true;
+      break;
+    }
+
+    // same format as the core : addr, type, cycle & an optional host
+    unsigned long long addr = 0;
+    unsigned long long cycle = 0;
+    int type = 0;
+    int host = 0;
+    if (std::sscanf(line.c_str(), "%llu %d %llu %d", &addr, &type, &cycle, &host) < 3) {
+      continue;
+    }
+    ASSERTM(host >= 0, "trace host id should not be negative\n");
+
+    trace_ent_s ent;
+    ent.m_addr = addr;
+    ent.m_write = (type == 1);
+    ent.m_cycle = cycle;
+    ent.m_host = host;
+    m_trace.push_back(ent);
+  }
+}
+
+void lockstep_c::run_epoch(int worker, int num_workers, Counter epoch_end) {
+  for (int ii = worker; ii < (int)m_lanes.size(); ii += num_workers) {
+    lockstep_lane_s* lane = &m_lanes[ii];
+    while (lane->m_cycle < epoch_end && !done(lane)) {
+      run_a_cycle(lane);
+    }
+  }
+}
+
+void lockstep_c::run_a_cycle(lockstep_lane_s* lane) {
+  // insert up to one request per cycle, like the core
+  Counter idx = lane->m_pos - m_trace_base;
+  if (idx < m_trace.size() && m_trace[idx].m_cycle <= lane->m_cycle) {
+    const trace_ent_s& ent = m_trace[idx];
+    int host = ent.m_host % lane->m_sim->m_num_hosts;
+    if (lane->m_sim->insert_request(ent.m_addr, ent.m_write, lane, host) != 0) {
+      lane->m_pos++;
+    }
+  }
+
+  lane->m_sim->run_a_cycle(false);
+  lane->m_cycle++;
+}
+
+bool lockstep_c::done(lockstep_lane_s* lane) {
+  return m_trace_eof && lane->m_pos == m_trace_base + m_trace.size() &&
+         lane->m_returned == lane->m_pos;
+}
+
+void lockstep_c::lockstep_callback(Addr, bool, Counter, void *req) {
+  lockstep_lane_s* lane = static_cast<lockstep_lane_s*>(req);
+  lane->m_returned++;
+}
+
+} // namespace CXL
@@ -0,0 +1,101 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : lockstep.h
+ * Description  : Lockstep simulation of several configurations from one trace decode
+ *********************************************************************************************/
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "global_types.h"
+#include "global_defs.h"
+
+namespace cxlsim {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// decoded trace request
+typedef struct trace_ent_s {
+  Addr m_addr;
+  bool m_write;
+  Counter m_cycle; /**< io cycle to insert at */
+  int m_host;
+} trace_ent_s;
+
+// one configuration : a simulator & its position in the shared trace
+typedef struct lockstep_lane_s {
+  cxlsim_c* m_sim;
+  Counter m_cycle; /**< io cycle */
+  Counter m_pos; /**< trace index of the next request to insert */
+  Counter m_returned; /**< requests returned */
+} lockstep_lane_s;
+
+// drives the simulators of multi_config_file in lockstep : the main thread
+// decodes the trace an epoch (multi_epoch io cycles) ahead, then worker
+// threads advance the simulators through the epoch. decoded requests are
+// kept until the slowest simulator has inserted them
+class lockstep_c {
+public:
+  lockstep_c(cxlsim_c* simBase, int argc, char** argv);
+  ~lockstep_c();
+
+  void set_tracefile(std::string filename);
+  void run_sim();
+
+private:
+  lockstep_c(); // do not implement
+
+  void lockstep_callback(Addr addr, bool write, Counter req_id, void *req);
+  void decode(Counter epoch_end); /**< decode requests issued before epoch_end */
+  void run_epoch(int worker, int num_workers, Counter epoch_end);
+  void run_a_cycle(lockstep_lane_s* lane);
+  bool done(lockstep_lane_s* lane);
+
+public:
+  cxlsim_c* m_simBase; /**< base simulator : knobs only */
+
+private:
+  std::string m_tracefilename;
+  std::ifstream m_tracefile;
+  bool m_trace_eof; /**< every request is decoded */
+  std::deque<trace_ent_s> m_trace; /**< decoded requests not inserted everywhere */
+  Counter m_trace_base; /**< trace index of m_trace.front() */
+  Counter m_epoch; /**< io cycles per epoch */
+  int m_num_threads; /**< worker threads */
+  std::vector<lockstep_lane_s> m_lanes;
+};
+
+} //namespace CXL
+
+#endif //LOCKSTEP_H
@@ -36,6 +36,11 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "cxlsim.h"
 #include "core.h"
+#include "traffic_gen.h"
+#include "loaded_lat.h"
+#include "lockstep.h"
+#include "shm_frontend.h"
+#include "all_knobs.h"
 #include "packet_info.h"
 #include "global_types.h"
 
@@ -44,12 +49,35 @@ int main(int argc, char **argv) {
   cxlsim::cxlsim_c* simBase = new cxlsim::cxlsim_c();
   simBase->init(argc, argv);
 
-  // init core
-  cxlsim::core_c* my_core = new cxlsim::core_c(simBase);
+  // run simulation : several configurations on one trace, a host simulator
+  // in another process, loaded latency sweep, synthetic traffic or the
+  // trace through a core
+  if (simBase->m_knobs->KNOB_MULTI_CONFIG_FILE->getValue() != "none") {
+    cxlsim::lockstep_c* my_lockstep = new cxlsim::lockstep_c(simBase, argc, argv);
+    my_lockstep->set_tracefile("../trace/debug-origin.txt");
+    my_lockstep->run_sim();
 
-  // run simulation
-  my_core->set_tracefile("../trace/debug-origin.txt");
-  my_core->run_sim();
+    // the base simulator only held the knobs
+    delete my_lockstep;
+    delete simBase;
+    return 0;
+  } else if (simBase->m_knobs->KNOB_SHM_NAME->getValue() != "none") {
+    // finalizes itself once the host has sent its exit
+    cxlsim::shm_frontend_c* my_frontend = new cxlsim::shm_frontend_c(simBase);
+    my_frontend->run_sim();
+    delete my_frontend;
+    return 0;
+  } else if (simBase->m_knobs->KNOB_LOADED_LAT_ENABLE->getValue()) {
+    cxlsim::loaded_lat_c* my_ll = new cxlsim::loaded_lat_c(simBase);
+    my_ll->run_sim();
+  } else if (simBase->m_knobs->KNOB_TRAFFIC_PATTERN->getValue() != "none") {
+    cxlsim::traffic_gen_c* my_gen = new cxlsim::traffic_gen_c(simBase);
+    my_gen->run_sim();
+  } else {
+    cxlsim::core_c* my_core = new cxlsim::core_c(simBase);
+    my_core->set_tracefile("../trace/debug-origin.txt");
+    my_core->run_sim();
+  }
 
   // dump stats
   simBase->finalize();
@@ -0,0 +1,197 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : mxp_prefetcher.cc
+ * Description  : Prefetch candidate generator of the CXL type 3 device
+ *********************************************************************************************/
+
+#include <iostream>
+#include <cstdlib>
+
+#include "mxp_prefetcher.h"
+#include "cxlsim.h"
+#include "checkpoint.h"
+
+#include "all_knobs.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+mxp_prefetcher_c::mxp_prefetcher_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+
+  std::string type = *KNOB(KNOB_MXP_PREF_TYPE);
+  m_type = MAX_PREF_TYPES;
+  for (int ii = 0; ii < MAX_PREF_TYPES; ii++) {
+    if (type == pref_type_string[ii]) {
+      m_type = static_cast<MXP_PREF_TYPE>(ii);
+      break;
+    }
+  }
+  ASSERTM(m_type != MAX_PREF_TYPES, "unknown mxp_pref_type\n");
+
+  m_degree = CFG(KNOB_MXP_PREF_DEGREE);
+  m_region_bits = CFG(KNOB_MXP_PREF_REGION_BITS);
+  m_table_size = CFG(KNOB_MXP_PREF_TABLE_SIZE);
+  m_line_size = CFG(KNOB_RAMULATOR_CACHELINE_SIZE);
+  m_conf_thresh = 2;
+}
+
+bool mxp_prefetcher_c::enabled() {
+  return m_type != PREF_NONE;
+}
+
+void mxp_prefetcher_c::train(Addr line, std::list<Addr>& cand) {
+  switch (m_type) {
+    case PREF_NEXTLINE:
+      train_nextline(line, cand);
+      break;
+    case PREF_STRIDE:
+      train_stride(line, cand);
+      break;
+    case PREF_STREAM:
+      train_stream(line, cand);
+      break;
+    default:
+      break;
+  }
+}
+
+void mxp_prefetcher_c::train_nextline(Addr line, std::list<Addr>& cand) {
+  add_candidates(line, 1, cand);
+}
+
+// detect a constant stride between consecutive accesses to the same region
+void mxp_prefetcher_c::train_stride(Addr line, std::list<Addr>& cand) {
+  Addr tag = line >> m_region_bits;
+  int64 line_num = static_cast<int64>(line / m_line_size);
+
+  for (auto iter = m_table.begin(); iter != m_table.end(); ++iter) {
+    if (iter->m_tag != tag) {
+      continue;
+    }
+
+    pref_entry_s entry = *iter;
+    m_table.erase(iter);
+
+    int64 stride = line_num - static_cast<int64>(entry.m_last_line / m_line_size);
+    if (stride != 0 && stride == entry.m_stride) {
+      if (entry.m_conf < m_conf_thresh) entry.m_conf++;
+    } else {
+      entry.m_stride = stride;
+      entry.m_conf = 0;
+    }
+    entry.m_last_line = line;
+    m_table.push_front(entry);
+
+    if (entry.m_conf >= m_conf_thresh) {
+      add_candidates(line, entry.m_stride, cand);
+    }
+    return;
+  }
+
+  pref_entry_s* entry = alloc_entry();
+  entry->m_tag = tag;
+  entry->m_last_line = line;
+}
+
+// follow ascending/descending streams of nearby cachelines
+void mxp_prefetcher_c::train_stream(Addr line, std::list<Addr>& cand) {
+  int64 line_num = static_cast<int64>(line / m_line_size);
+  int64 window = 4 * m_degree;
+
+  for (auto iter = m_table.begin(); iter != m_table.end(); ++iter) {
+    int64 delta = line_num - static_cast<int64>(iter->m_last_line / m_line_size);
+    if (delta == 0 || std::llabs(delta) > window) {
+      continue;
+    }
+
+    pref_entry_s entry = *iter;
+    m_table.erase(iter);
+
+    int64 dir = (delta > 0) ? 1 : -1;
+    if (dir == entry.m_stride) {
+      if (entry.m_conf < m_conf_thresh) entry.m_conf++;
+    } else {
+      entry.m_stride = dir;
+      entry.m_conf = 0;
+    }
+    entry.m_last_line = line;
+    m_table.push_front(entry);
+
+    if (entry.m_conf >= m_conf_thresh) {
+      add_candidates(line, entry.m_stride, cand);
+    }
+    return;
+  }
+
+  pref_entry_s* entry = alloc_entry();
+  entry->m_last_line = line;
+}
+
+void mxp_prefetcher_c::add_candidates(Addr line, int64 stride,
+                                      std::list<Addr>& cand) {
+  int64 line_num = static_cast<int64>(line / m_line_size);
+  for (int ii = 1; ii <= m_degree; ii++) {
+    int64 target = line_num + stride * ii;
+    if (target < 0) {
+      break;
+    }
+    cand.push_back(static_cast<Addr>(target) * m_line_size);
+  }
+}
+
+pref_entry_s* mxp_prefetcher_c::alloc_entry() {
+  if ((int)m_table.size() >= m_table_size) {
+    m_table.pop_back();
+  }
+
+  pref_entry_s entry;
+  entry.m_tag = 0;
+  entry.m_last_line = 0;
+  entry.m_stride = 0;
+  entry.m_conf = 0;
+  m_table.push_front(entry);
+  return &m_table.front();
+}
+
+void mxp_prefetcher_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_table);
+}
+
+void mxp_prefetcher_c::print() {
+  std::cout << "prefetcher " << pref_type_string[m_type] << ": ";
+  for (auto entry : m_table) {
+    std::cout << "(" << entry.m_tag << ":" << entry.m_last_line << ":"
+              << entry.m_stride << ":" << entry.m_conf << ") ";
+  }
+  std::cout << std::endl;
+}
+
+} // namespace CXL
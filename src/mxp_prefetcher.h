@@ -0,0 +1,123 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : mxp_prefetcher.h
+ * Description  : Prefetch candidate generator of the CXL type 3 device
+ *********************************************************************************************/
+
+#ifndef MXP_PREFETCHER_H
+#define MXP_PREFETCHER_H
+
+#include <list>
+#include <string>
+
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+typedef enum MXP_PREF_TYPE {
+  PREF_NONE = 0,
+  PREF_NEXTLINE, /**< next-N-line */
+  PREF_STRIDE,   /**< stride per region */
+  PREF_STREAM,   /**< stream table */
+  MAX_PREF_TYPES
+} MXP_PREF_TYPE;
+
+static const std::string pref_type_string[MAX_PREF_TYPES] = {
+  "none",
+  "nextline",
+  "stride",
+  "stream"
+};
+
+// prefetcher table entry (stride : per region, stream : per stream)
+typedef struct pref_entry_s {
+  Addr m_tag; /**< region number (stride) */
+  Addr m_last_line; /**< last cacheline accessed */
+  int64 m_stride; /**< stride (stride) or direction (stream) in lines */
+  int m_conf; /**< confidence */
+} pref_entry_s;
+
+class mxp_prefetcher_c {
+public:
+  /**
+   * Constructor
+   */
+  mxp_prefetcher_c(cxlsim_c* simBase);
+
+  /**
+   * Train with a demand read & append prefetch candidates to cand
+   */
+  void train(Addr line, std::list<Addr>& cand);
+
+  /**
+   * Returns true if the prefetcher is enabled
+   */
+  bool enabled();
+
+  void print();
+
+  /**
+   * Save or restore the table
+   */
+  void checkpoint(checkpoint_c* ckpt);
+
+private:
+  mxp_prefetcher_c(); // do not implement
+
+  void train_nextline(Addr line, std::list<Addr>& cand);
+  void train_stride(Addr line, std::list<Addr>& cand);
+  void train_stream(Addr line, std::list<Addr>& cand);
+
+  /**
+   * Push candidates line + k * stride (k = 1 .. degree)
+   */
+  void add_candidates(Addr line, int64 stride, std::list<Addr>& cand);
+
+  /**
+   * Allocate a table entry, replacing the lru entry if the table is full
+   */
+  pref_entry_s* alloc_entry();
+
+private:
+  MXP_PREF_TYPE m_type; /**< prefetcher type */
+  int m_degree; /**< number of lines to prefetch per trigger */
+  int m_region_bits; /**< stride region size */
+  int m_table_size; /**< stride/stream table size */
+  int m_line_size; /**< cacheline size */
+  int m_conf_thresh; /**< confidence to start prefetching */
+  std::list<pref_entry_s> m_table; /**< table entries in mru order */
+
+  cxlsim_c* m_simBase;
+};
+
+} // namespace CXL
+
+#endif // MXP_PREFETCHER_H
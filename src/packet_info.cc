@@ -57,6 +57,13 @@ void cxl_req_s::init(void) {
   m_addr = 0;
   m_write = false;
   m_req = NULL;
+  m_host = 0;
+  m_dpa = 0;
+  m_issue_cycle = 0;
+  m_early_done = 0;
+  m_devload = DEVLOAD_LIGHT;
+  m_traced = false;
+  m_trace_cycle = 0;
 }
 
 void cxl_req_s::print(void) {
@@ -79,6 +86,8 @@ void message_s::init(void) {
   m_parent = NULL;
   m_childs.clear();
   m_arrived_child = 0;
+  m_chunk = 0;
+  m_critical = false;
 
   m_txvc_insert_start = 0;
   m_txvc_insert_done = 0;
@@ -103,7 +112,7 @@ bool message_s::rxvc_rdy(Counter cycle) {
 void message_s::init_data_msg(message_s* parent) {
   assert(parent->m_type == M2S_RWD || parent->m_type == S2M_DRS);
 
-  m_bits = *KNOB(KNOB_PCIE_DATA_MSG_BITS);
+  m_bits = CFG(KNOB_PCIE_DATA_MSG_BITS);
   m_type = (parent->m_type == M2S_RWD) 
             ? M2S_DATA
             : S2M_DATA;
@@ -119,7 +128,7 @@ void message_s::inc_arrived_child(void) {
 }
 
 bool message_s::child_waiting(void) {
-  return (m_arrived_child < *KNOB(KNOB_PCIE_SLOTS_PER_FLIT));
+  return (m_arrived_child < CFG(KNOB_PCIE_SLOTS_PER_FLIT));
 }
 
 void message_s::print(void) {
@@ -252,7 +261,7 @@ bool flit_s::rollover(void) {
       return false;
     }
   }
-  return (num_slots() < *KNOB(KNOB_PCIE_SLOTS_PER_FLIT));
+  return (num_slots() < CFG(KNOB_PCIE_SLOTS_PER_FLIT));
 }
 
 void flit_s::print(void) {
@@ -59,6 +59,22 @@ typedef enum channel_type {
   MAX_CHANNEL
 } channel_type;
 
+// DevLoad field of S2M NDR/DRS (QoS telemetry)
+typedef enum DEVLOAD_TYPE {
+  DEVLOAD_LIGHT = 0, /**< light load */
+  DEVLOAD_OPTIMAL,   /**< optimal load */
+  DEVLOAD_MODERATE,  /**< moderate overload */
+  DEVLOAD_SEVERE,    /**< severe overload */
+  MAX_DEVLOAD_TYPES
+} DEVLOAD_TYPE;
+
+static const std::string devload_type_string[MAX_DEVLOAD_TYPES] = {
+  "LIGHT",
+  "OPTIMAL",
+  "MODERATE",
+  "SEVERE"
+};
+
 //////////////////////////////////////////////////////////////////////////////
 
 typedef struct cxl_req_s {
@@ -70,6 +86,13 @@ typedef struct cxl_req_s {
   Addr m_addr;
   bool m_write;
   void* m_req;
+  int m_host; /**< host (root complex) that issued the req */
+  Addr m_dpa; /**< device physical address (decoded by the switch & the device) */
+  Counter m_issue_cycle; /**< cycle the req entered cxlsim_c::insert_request */
+  Counter m_early_done; /**< cycle the critical chunk completed the req */
+  DEVLOAD_TYPE m_devload; /**< DevLoad stamped on the response */
+  bool m_traced; /**< lifecycle is written to the trace */
+  Counter m_trace_cycle; /**< start of the current device stage (trace) */
   cxlsim_c* m_simBase;
 } cxl_req_s;
 
@@ -118,6 +141,8 @@ typedef struct message_s {
   message_s* m_parent;
   std::list<message_s*> m_childs;
   int m_arrived_child;
+  int m_chunk; /**< data chunk index within the cacheline */
+  bool m_critical; /**< data chunk holding the requested address */
 
   Counter m_txvc_insert_start;
   Counter m_txvc_insert_done;
@@ -35,11 +35,16 @@ POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************************************/
 
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <vector>
 
 #include "pcie_endpoint.h"
 #include "pcie_vcbuff.h"
+#include "checkpoint.h"
+#include "trace_event.h"
+#include "sim_profile.h"
 
 #include "utils.h"
 #include "all_knobs.h"
@@ -52,27 +57,65 @@ pcie_ep_c::pcie_ep_c(cxlsim_c* simBase) {
   // simulation related
   m_simBase = simBase;
   m_cycle = 0;
+  m_txphys_bits = 0;
+  m_txphys_flits = 0;
+  m_trace_pid = 0;
+  m_trace_tid = 0;
 
-  // set memory request size
-  m_lanes = *KNOB(KNOB_PCIE_LANES);
-  m_perlane_bw = *KNOB(KNOB_PCIE_PER_LANE_BW);
   m_prev_txphys_cycle = 0;
   m_peer_ep = NULL;
 
-  ASSERTM((m_lanes & (m_lanes - 1)) == 0, "number of lanes should be power of 2\n");
-
   m_txvc = new vc_buff_c(simBase);
   m_rxvc = new vc_buff_c(simBase);
-  m_rxvc_bw = *KNOB(KNOB_PCIE_RXVC_BW);
+  m_rxvc_bw = CFG(KNOB_PCIE_RXVC_BW);
 
   // initialize dll
-/* m_txdll_cap = *KNOB(KNOB_PCIE_TXDLL_CAPACITY); */
-  m_txreplay_cap = *KNOB(KNOB_PCIE_TXREPLAY_CAPACITY);
+/* m_txdll_cap = CFG(KNOB_PCIE_TXDLL_CAPACITY); */
+  m_txreplay_cap = CFG(KNOB_PCIE_TXREPLAY_CAPACITY);
+
+  // physical layers are set up by init, once the link is known
+  m_phys_cap = 1;
+  m_phys_latency = 0;
+  m_retimer_latency = 0;
+
+  // link power management
+  m_power_state = LINK_L0;
+  m_l0p_idle = CFG(KNOB_PCIE_L0P_IDLE);
+  m_l1_idle = CFG(KNOB_PCIE_L1_IDLE);
+  m_wake_latency[LINK_L0] = 0;
+  m_wake_latency[LINK_L0P] = CFG(KNOB_PCIE_L0P_EXIT_LATENCY);
+  m_wake_latency[LINK_L1] = CFG(KNOB_PCIE_L1_EXIT_LATENCY);
+  m_l0p_latency = 0;
+  m_l0p_until = 0;
+  m_l1_wake_until = 0;
+  for (int ii = 0; ii < MAX_LINK_POWER_STATES; ++ii) {
+    m_static_power[ii] = 0.0;
+    m_power_cycles[ii] = 0;
+  }
+}
+
+pcie_ep_c::~pcie_ep_c() {
+  delete m_txvc;
+  delete m_rxvc;
+}
+
+void pcie_ep_c::init(int id, int link, bool master, pool_c<message_s>* msg_pool, 
+                     pool_c<slot_s>* slot_pool,
+                     pool_c<flit_s>* flit_pool, pcie_ep_c* peer) {
+  m_id = id;
+  m_master = master;
+  m_msg_pool = msg_pool;
+  m_slot_pool = slot_pool;
+  m_flit_pool = flit_pool;
+  m_peer_ep = peer;
+
+  // initialize physical layers : the two directions of a link may differ
+  m_tx_link = get_link(link, m_master);
+  m_rx_link = get_link(link, !m_master);
 
-  // initialize physical layers 
-  // the number for consecutive flits that can be sent together 
+  // the number for consecutive flits that can be received together 
   // varies by the number of lanes (see CXL spec 2.0 physical layer)
-  switch (m_lanes) {
+  switch (m_rx_link.m_lanes) {
     case 16: 
       m_phys_cap = 4; 
       break;
@@ -89,32 +132,22 @@ pcie_ep_c::pcie_ep_c(cxlsim_c* simBase) {
       break;
   }
 
-  float freq = *KNOB(KNOB_CLOCK_IO);
-  int lanes = *KNOB(KNOB_PCIE_LANES);
-  int flit_bits = *KNOB(KNOB_PCIE_FLIT_BITS);
-  m_phys_latency = 
-    static_cast<Counter>(flit_bits / (lanes * m_perlane_bw) * freq);
-}
+  m_phys_latency = get_flit_cycles(m_tx_link);
+  m_retimer_latency = m_tx_link.m_retimers * CFG(KNOB_PCIE_RETIMER_LATENCY);
 
-pcie_ep_c::~pcie_ep_c() {
-  delete m_txvc;
-  delete m_rxvc;
-}
+  // static power of the tx direction scales with the active lanes
+  int l0p_lanes = std::min(m_tx_link.m_lanes, (int)CFG(KNOB_PCIE_L0P_LANES));
+  pcie_link_s l0p_link = m_tx_link;
+  l0p_link.m_lanes = l0p_lanes;
+  m_l0p_latency = get_flit_cycles(l0p_link);
+  m_static_power[LINK_L0] = m_tx_link.m_lanes * CFG(KNOB_PCIE_LANE_POWER);
+  m_static_power[LINK_L0P] = l0p_lanes * CFG(KNOB_PCIE_LANE_POWER);
+  m_static_power[LINK_L1] = CFG(KNOB_PCIE_L1_POWER);
 
-void pcie_ep_c::init(int id, bool master, pool_c<message_s>* msg_pool, 
-                     pool_c<slot_s>* slot_pool,
-                     pool_c<flit_s>* flit_pool, pcie_ep_c* peer) {
-  m_id = id;
-  m_master = master;
-  m_msg_pool = msg_pool;
-  m_slot_pool = slot_pool;
-  m_flit_pool = flit_pool;
-  m_peer_ep = peer;
-
-  int tx_channel_cap = *KNOB(KNOB_PCIE_TXVC_CAPACITY);
-  int rx_channel_cap = *KNOB(KNOB_PCIE_RXVC_CAPACITY);
-  int tx_flitbuff_cap = *KNOB(KNOB_PCIE_TXFLITBUFF_CAPACITY);
-  int rx_flitbuff_cap = *KNOB(KNOB_PCIE_RXFLITBUFF_CAPACITY);
+  int tx_channel_cap = CFG(KNOB_PCIE_TXVC_CAPACITY);
+  int rx_channel_cap = CFG(KNOB_PCIE_RXVC_CAPACITY);
+  int tx_flitbuff_cap = CFG(KNOB_PCIE_TXFLITBUFF_CAPACITY);
+  int rx_flitbuff_cap = CFG(KNOB_PCIE_RXFLITBUFF_CAPACITY);
 
   m_txvc->init(/* tx? */true,  m_master, 
                 m_msg_pool, m_slot_pool, m_flit_pool, 
@@ -149,10 +182,54 @@ void pcie_ep_c::insert_phys(flit_s* flit) {
   m_rxphys_q.push_back(flit);
 }
 
+Counter pcie_ep_c::get_rx_flit_cycles() {
+  return get_flit_cycles(m_rx_link);
+}
+
+Counter pcie_ep_c::get_tx_idle_since() {
+  return m_prev_txphys_cycle;
+}
+
+int pcie_ep_c::get_tx_lanes() {
+  return m_tx_link.m_lanes;
+}
+
+double pcie_ep_c::get_dynamic_energy() {
+  return 1.0 * m_txphys_flits * CFG(KNOB_PCIE_FLIT_BITS) * CFG(KNOB_PCIE_ENERGY_PER_BIT);
+}
+
+// mW over an io cycle of 1 / clock_io ns : pJ
+double pcie_ep_c::get_static_energy() {
+  double energy = 0.0;
+  for (int ii = 0; ii < MAX_LINK_POWER_STATES; ++ii) {
+    energy += m_power_cycles[ii] * m_static_power[ii];
+  }
+  return energy / CFG(KNOB_CLOCK_IO);
+}
+
 bool pcie_ep_c::has_free_rxvc(int vc_id) {
   return (m_rxvc->full(vc_id) == false);
 }
 
+int pcie_ep_c::replay_size() {
+  return (int)m_txreplay_buff.size();
+}
+
+void pcie_ep_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_prev_txphys_cycle);
+  ckpt->io(m_txreplay_buff);
+  ckpt->io(m_rxphys_q);
+  ckpt->io(m_cycle);
+  ckpt->io(m_txphys_bits);
+  ckpt->io(m_txphys_flits);
+  ckpt->io(m_power_state);
+  ckpt->io(m_power_cycles);
+  ckpt->io(m_l0p_until);
+  ckpt->io(m_l1_wake_until);
+  m_txvc->checkpoint(ckpt);
+  m_rxvc->checkpoint(ckpt);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // private
 
@@ -160,6 +237,126 @@ Counter pcie_ep_c::get_phys_latency() {
   return m_phys_latency;
 }
 
+Counter pcie_ep_c::get_flit_cycles(const pcie_link_s& link) {
+  float freq = CFG(KNOB_CLOCK_IO);
+  int flit_bits = CFG(KNOB_PCIE_FLIT_BITS);
+  return static_cast<Counter>(flit_bits / (link.m_lanes * link.m_perlane_bw) * freq);
+}
+
+// L0p is per direction, L1 takes the whole link : both directions idle
+void pcie_ep_c::update_power_state() {
+  Counter idle = m_cycle > m_prev_txphys_cycle ? m_cycle - m_prev_txphys_cycle : 0;
+  Counter peer_since = m_peer_ep->get_tx_idle_since();
+  Counter peer_idle = m_cycle > peer_since ? m_cycle - peer_since : 0;
+
+  LINK_POWER_STATE state = LINK_L0;
+  if (m_l1_idle && std::min(idle, peer_idle) >= m_l1_idle) {
+    state = LINK_L1;
+  } else if (m_l0p_idle && idle >= m_l0p_idle) {
+    state = LINK_L0P;
+  }
+
+  if (state != m_power_state) {
+    if (state == LINK_L0P) {
+      STAT_EVENT(PCIE_L0P_ENTRY);
+    } else if (state == LINK_L1) {
+      STAT_EVENT(PCIE_L1_ENTRY);
+    }
+    m_power_state = state;
+  }
+  m_power_cycles[state]++;
+  STAT_EVENT(PCIE_L0_CYCLES + state);
+}
+
+// each entry of pcie_link_overrides is link:dir:lanes:rate:arbmux:retimers
+pcie_link_s pcie_ep_c::get_link(int link, bool m2s) {
+  pcie_link_s params;
+  params.m_lanes = m2s ? CFG(KNOB_PCIE_M2S_LANES) : CFG(KNOB_PCIE_S2M_LANES);
+  params.m_perlane_bw = 
+    m2s ? CFG(KNOB_PCIE_M2S_PER_LANE_BW) : CFG(KNOB_PCIE_S2M_PER_LANE_BW);
+  if (params.m_lanes == 0) {
+    params.m_lanes = CFG(KNOB_PCIE_LANES);
+  }
+  if (params.m_perlane_bw == 0) {
+    params.m_perlane_bw = CFG(KNOB_PCIE_PER_LANE_BW);
+  }
+  params.m_arbmux_latency = CFG(KNOB_PCIE_ARBMUX_LATENCY);
+  params.m_retimers = CFG(KNOB_PCIE_RETIMERS);
+
+  std::string overrides = *KNOB(KNOB_PCIE_LINK_OVERRIDES);
+  std::size_t pos = 0;
+  while (overrides != "none" && pos < overrides.size()) {
+    std::size_t next = overrides.find(';', pos);
+    if (next == std::string::npos) {
+      next = overrides.size();
+    }
+    std::string entry = overrides.substr(pos, next - pos);
+    pos = next + 1;
+
+    std::vector<std::string> fields;
+    std::size_t field = 0;
+    while (true) {
+      std::size_t end = entry.find(':', field);
+      fields.push_back(entry.substr(field, end - field));
+      if (end == std::string::npos) {
+        break;
+      }
+      field = end + 1;
+    }
+    ASSERTM(fields.size() == 6, 
+            "pcie_link_overrides : link:dir:lanes:rate:arbmux:retimers\n");
+    ASSERTM((fields[1] == "m2s" || fields[1] == "s2m"), 
+            "pcie_link_overrides : dir is m2s or s2m\n");
+
+    // the fields are checked before they are converted, so that a typo
+    // fails with a message instead of an exception out of std::stoi
+    auto set = [](const std::string& value) { 
+      return !value.empty() && value != "-"; 
+    };
+    auto is_int = [](const std::string& value) {
+      char* end = NULL;
+      std::strtoll(value.c_str(), &end, 10);
+      return !value.empty() && *end == '\0';
+    };
+    auto is_real = [](const std::string& value) {
+      char* end = NULL;
+      std::strtod(value.c_str(), &end);
+      return !value.empty() && *end == '\0';
+    };
+    ASSERTM(is_int(fields[0]), "pcie_link_overrides : link should be an integer\n");
+    ASSERTM((!set(fields[2]) || is_int(fields[2])), 
+            "pcie_link_overrides : lanes should be an integer or -\n");
+    ASSERTM((!set(fields[3]) || is_real(fields[3])), 
+            "pcie_link_overrides : rate should be a number (GT/s) or -\n");
+    ASSERTM((!set(fields[4]) || (is_int(fields[4]) && fields[4][0] != '-')), 
+            "pcie_link_overrides : arbmux should be a non-negative integer or -\n");
+    ASSERTM((!set(fields[5]) || (is_int(fields[5]) && fields[5][0] != '-')), 
+            "pcie_link_overrides : retimers should be a non-negative integer or -\n");
+
+    if (std::atoi(fields[0].c_str()) != link || (fields[1] == "m2s") != m2s) {
+      continue;
+    }
+
+    if (set(fields[2])) {
+      params.m_lanes = std::atoi(fields[2].c_str());
+    }
+    if (set(fields[3])) {
+      params.m_perlane_bw = std::atof(fields[3].c_str());
+    }
+    if (set(fields[4])) {
+      params.m_arbmux_latency = std::strtoull(fields[4].c_str(), NULL, 10);
+    }
+    if (set(fields[5])) {
+      params.m_retimers = std::atoi(fields[5].c_str());
+    }
+  }
+
+  ASSERTM((params.m_lanes > 0 && (params.m_lanes & (params.m_lanes - 1)) == 0), 
+          "number of lanes should be power of 2\n");
+  ASSERTM(params.m_perlane_bw > 0, "per lane rate should be positive\n");
+  return params;
+}
+
 void pcie_ep_c::refresh_replay_buffer() {
   while (m_txreplay_buff.size()) {
     flit_s* flit = m_txreplay_buff.front();
@@ -178,9 +375,47 @@ void pcie_ep_c::release_msg(message_s* msg) {
   m_msg_pool->release_entry(msg);
 }
 
+std::string pcie_ep_c::trace_name(bool tx, const char* stage) {
+  // rc transmits m2s & receives s2m
+  bool m2s = (m_master == tx);
+  return std::string(m2s ? "m2s " : "s2m ") + stage;
+}
+
+// stages up to leaving the tx vc, written as the flit enters the replay buffer
+void pcie_ep_c::trace_tx_msg(message_s* msg, flit_s* flit) {
+  trace_event_c* trace = m_simBase->m_trace;
+  cxl_req_s* req = msg->m_req;
+
+  trace_queue(req, msg->m_txvc_insert_start);
+  trace->req_span(req, trace_name(true, "txvc"), msg->m_txvc_insert_start,
+                  flit->m_flit_gen_cycle);
+  trace->req_span(req, trace_name(true, "flit"), flit->m_flit_gen_cycle, 
+                  m_cycle);
+}
+
+// link stages, written as the flit leaves the rx dll
+void pcie_ep_c::trace_rx_msg(message_s* msg, flit_s* flit) {
+  trace_event_c* trace = m_simBase->m_trace;
+  cxl_req_s* req = msg->m_req;
+
+  trace->req_span(req, trace_name(false, "replay"), 
+                  flit->m_txreplay_insert_start, flit->m_phys_start);
+  trace->req_span(req, trace_name(false, "phys"), flit->m_phys_start, 
+                  flit->m_phys_done);
+  trace->req_span(req, trace_name(false, "rxdll"), flit->m_phys_done, m_cycle);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // protected
 
+void pcie_ep_c::trace_queue(cxl_req_s* req, Counter end) {
+  if (m_master) {
+    m_simBase->m_trace->req_span(req, "rc pending", req->m_issue_cycle, end);
+  } else {
+    m_simBase->m_trace->req_span(req, "dev resp q", req->m_trace_cycle, end);
+  }
+}
+
 // virtual class
 // should call push_txvc internally
 // look at pcie_rc_c, cxl_t3_c for examples
@@ -210,6 +445,11 @@ void pcie_ep_c::end_transaction() {
   return;
 }
 
+// used for end_transaction (critical chunk first)
+cxl_req_s* pcie_ep_c::pull_crit_rxvc() {
+  return m_rxvc->pull_crit_req();
+}
+
 // used for end_transaction
 cxl_req_s* pcie_ep_c::pull_rxvc() {
   // choose the vc buffer with minimum free space left
@@ -238,8 +478,13 @@ cxl_req_s* pcie_ep_c::pull_rxvc() {
     STAT_EVENT(PCIE_RXTRANS_BASE);
     STAT_EVENT_N(AVG_PCIE_RXTRANS_LATENCY, (m_cycle - msg->m_rxvc_insert_start));
 
+    if (msg->m_req->m_traced) {
+      m_simBase->m_trace->req_span(msg->m_req, trace_name(false, "rxvc"),
+                                   msg->m_rxvc_insert_start, m_cycle);
+    }
+
 /* if (msg->is_wdata_msg()) */
-/* assert(msg->m_arrived_child == *KNOB(KNOB_PCIE_SLOTS_PER_FLIT)); */
+/* assert(msg->m_arrived_child == CFG(KNOB_PCIE_SLOTS_PER_FLIT)); */
 
     cxl_req_s* req = msg->m_req;
     release_msg(msg);
@@ -266,11 +511,15 @@ bool pcie_ep_c::check_peer_credit(flit_s* flit) {
 //////////////////////////////////////////////////////////////////////////////
 
 void pcie_ep_c::process_txtrans() {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_TXTRANS);
+
   m_txvc->generate_flits();
   m_txvc->run_a_cycle();
 }
 
 void pcie_ep_c::process_txdll() {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_TXDLL);
+
   int cnt = 0;
   while (m_txreplay_cap > (int)m_txreplay_buff.size()) {
     flit_s* flit = m_txvc->peek_flit();
@@ -279,7 +528,7 @@ void pcie_ep_c::process_txdll() {
       bool fctrl_success = check_peer_credit(flit);
       if (fctrl_success) {
         flit->m_txreplay_insert_start = m_cycle;
-        flit->m_txreplay_insert_done = m_cycle + *KNOB(KNOB_PCIE_TXDLL_LATENCY);
+        flit->m_txreplay_insert_done = m_cycle + CFG(KNOB_PCIE_TXDLL_LATENCY);
 
         m_txreplay_buff.push_back(flit);
         m_txvc->pop_flit();
@@ -295,22 +544,30 @@ void pcie_ep_c::process_txdll() {
             } else {
               STAT_EVENT_N(AVG_PCIE_TXTRANS_LATENCY, 
                   (m_cycle - msg->m_txvc_insert_start));
+              if (msg->m_req->m_traced) {
+                trace_tx_msg(msg, flit);
+              }
             }
           }
         }
+      } else { // peer rx vc is full : retry next cycle
+        break;
       }
     } else {
       break;
     }
 
-    if (cnt == *KNOB(KNOB_PCIE_REPLAY_BW)) {
+    if (cnt == CFG(KNOB_PCIE_REPLAY_BW)) {
       break;
     }
   }
 }
 
 void pcie_ep_c::process_txphys() {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_TXPHYS);
+
   refresh_replay_buffer();
+  update_power_state();
 
   if (!m_peer_ep->phys_layer_full()) {
     for (auto cur_flit : m_txreplay_buff) {
@@ -319,28 +576,60 @@ void pcie_ep_c::process_txphys() {
       } else if (cur_flit->m_txreplay_insert_done <= m_cycle) {
         // - packets are sent serially so transmission starts only after
         //   the previous packet finished physical layer transmission
-        Counter lat = get_phys_latency() 
-                      + 2*(*KNOB(KNOB_PCIE_ARBMUX_LATENCY)); // tx & rx
         Counter start_cyc = std::max(m_prev_txphys_cycle, m_cycle);
+
+        // L1 is left by the whole link : the first flit of either direction
+        // wakes it up & both directions wait until it is back. L0p sends
+        // right away over the L0p lanes & the other lanes come back after
+        // the exit latency
+        if (m_power_state == LINK_L1) {
+          m_l1_wake_until = start_cyc + m_wake_latency[LINK_L1];
+          m_peer_ep->m_l1_wake_until = m_l1_wake_until;
+          m_power_state = LINK_L0;
+        }
+        if (start_cyc < m_l1_wake_until) {
+          STAT_EVENT(PCIE_LINK_WAKE);
+          STAT_EVENT_N(AVG_PCIE_WAKE_LATENCY, m_l1_wake_until - start_cyc);
+          start_cyc = m_l1_wake_until;
+          m_power_state = LINK_L0;
+        } else if (m_power_state == LINK_L0P) {
+          m_l0p_until = start_cyc + m_wake_latency[LINK_L0P];
+          m_power_state = LINK_L0;
+        }
+
+        Counter lat = get_phys_latency();
+        if (start_cyc < m_l0p_until) {
+          STAT_EVENT(PCIE_L0P_FLITS);
+          lat = m_l0p_latency;
+        }
+        lat += 2*(m_tx_link.m_arbmux_latency); // tx & rx
         Counter phys_finished = start_cyc + lat;
 
+        // retimers delay the flit without holding the next one back
         m_prev_txphys_cycle = phys_finished;
+        phys_finished += m_retimer_latency;
         cur_flit->m_phys_start = start_cyc;
         cur_flit->m_phys_done = phys_finished;
-        cur_flit->m_rxdll_done = phys_finished + *KNOB(KNOB_PCIE_RXDLL_LATENCY);
+        cur_flit->m_rxdll_done = phys_finished + CFG(KNOB_PCIE_RXDLL_LATENCY);
         cur_flit->m_phys_sent = true;
 
         // push to peer endpoint physical
         m_peer_ep->insert_phys(cur_flit);
 
+        if (m_simBase->m_trace->sample_flit(cur_flit)) {
+          m_simBase->m_trace->flit_span(cur_flit, this, start_cyc, phys_finished);
+        }
+
         // update dll stats
         STAT_EVENT(PCIE_TXDLL_BASE);
         STAT_EVENT_N(AVG_PCIE_TXDLL_LATENCY,
                     (m_cycle - cur_flit->m_txreplay_insert_start));
 
         // update goodput related stats
-        STAT_EVENT_N(PCIE_GOODPUT_BASE, *KNOB(KNOB_PCIE_FLIT_BITS));
+        STAT_EVENT_N(PCIE_GOODPUT_BASE, CFG(KNOB_PCIE_FLIT_BITS));
         STAT_EVENT_N(AVG_PCIE_GOODPUT, cur_flit->m_bits);
+        m_txphys_bits += cur_flit->m_bits;
+        m_txphys_flits++;
 
         break;
       }
@@ -349,6 +638,8 @@ void pcie_ep_c::process_txphys() {
 }
 
 void pcie_ep_c::process_rxphys() {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_RXPHYS);
+
   while (m_rxphys_q.size()) {
     flit_s* flit = m_rxphys_q.front();
 
@@ -361,6 +652,16 @@ void pcie_ep_c::process_rxphys() {
       STAT_EVENT(PCIE_RXDLL_BASE);
       STAT_EVENT_N(AVG_PCIE_RXDLL_LATENCY, (m_cycle - flit->m_phys_done));
 
+      if (m_simBase->m_trace->enabled()) {
+        for (auto slot : flit->m_slots) {
+          for (auto msg : slot->m_msgs) {
+            if (!msg->m_data && msg->m_req->m_traced) {
+              trace_rx_msg(msg, flit);
+            }
+          }
+        }
+      }
+
       m_rxvc->receive_flit(flit);
     } else {
       break;
@@ -369,10 +670,14 @@ void pcie_ep_c::process_rxphys() {
 }
 
 void pcie_ep_c::process_rxdll() {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_RXDLL);
+
   return;
 }
 
 void pcie_ep_c::process_rxtrans() {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_RXTRANS);
+
   m_rxvc->run_a_cycle();
 }
 
@@ -46,6 +46,28 @@ POSSIBILITY OF SUCH DAMAGE.
 
 namespace cxlsim {
 
+// one direction of a link
+typedef struct pcie_link_s {
+  int m_lanes; /**< lanes */
+  float m_perlane_bw; /**< per lane rate in GT/s */
+  Counter m_arbmux_latency; /**< arb/mux latency at each end */
+  int m_retimers; /**< retimers between the ends */
+} pcie_link_s;
+
+// power states of a link direction
+typedef enum LINK_POWER_STATE {
+  LINK_L0 = 0, /**< active, full width */
+  LINK_L0P,    /**< active, reduced width (pcie_l0p_lanes) */
+  LINK_L1,     /**< both directions idle, link down */
+  MAX_LINK_POWER_STATES
+} LINK_POWER_STATE;
+
+static const std::string link_power_state_string[MAX_LINK_POWER_STATES] = {
+  "l0",
+  "l0p",
+  "l1"
+};
+
 class pcie_ep_c {
 public:
   /**
@@ -60,8 +82,10 @@ public:
 
   /**
    * Initialize PCIe endpoint
+   * - link : id of the link to the peer (pcie_link_overrides), the tx side
+   *   of the master is the m2s direction
    */
-  void init(int id, bool master, pool_c<message_s>* msg_pool, 
+  void init(int id, int link, bool master, pool_c<message_s>* msg_pool, 
             pool_c<slot_s>* slot_pool,
             pool_c<flit_s>* flit_pool, pcie_ep_c* peer);
 
@@ -82,6 +106,37 @@ public:
 
   bool has_free_rxvc(int vc_id);
 
+  /**
+   * Cycles to receive a flit from the peer
+   */
+  Counter get_rx_flit_cycles();
+
+  /**
+   * Cycle the tx physical layer finished its last flit
+   */
+  Counter get_tx_idle_since();
+
+  /**
+   * Lanes of the tx direction
+   */
+  int get_tx_lanes();
+
+  /**
+   * Energy of the tx direction so far (pJ) : flit bits & static power
+   */
+  double get_dynamic_energy();
+  double get_static_energy();
+
+  /**
+   * Number of flits in the replay buffer
+   */
+  int replay_size();
+
+  /**
+   * Save or restore the state of the link layers
+   */
+  virtual void checkpoint(checkpoint_c* ckpt);
+
   /**
    * Print for debugging
    */
@@ -95,6 +150,22 @@ private:
    */
   Counter get_phys_latency();
 
+  /**
+   * Move the tx direction between power states, once a cycle before sending
+   */
+  void update_power_state();
+
+  /**
+   * Parameters of a direction of a link (pcie_link_overrides over the
+   * direction knobs over pcie_lanes & pcie_per_lane_bw)
+   */
+  pcie_link_s get_link(int link, bool m2s);
+
+  /**
+   * Cycles to serialize a flit over a direction of the link
+   */
+  Counter get_flit_cycles(const pcie_link_s& link);
+
   /**
    * Checks & updates the state of entries if the flit is received by the peer
    */
@@ -105,6 +176,17 @@ private:
    */
   void release_msg(message_s* msg);
 
+  /**
+   * Trace stage name prefixed with the direction (tx : sent by this endpoint)
+   */
+  std::string trace_name(bool tx, const char* stage);
+
+  /**
+   * Trace the lifecycle of a request message on the tx & rx side
+   */
+  void trace_tx_msg(message_s* msg, flit_s* flit);
+  void trace_rx_msg(message_s* msg, flit_s* flit);
+
   /**
    * Checks if the peer has enough rxvc entries left for this message type
    * (for flow control)
@@ -133,6 +215,11 @@ protected:
    */
   cxl_req_s* pull_rxvc();
 
+  /**
+   * Pull request whose critical data chunk arrived from RX VC buffer
+   */
+  cxl_req_s* pull_crit_rxvc();
+
   // PCIE TX layer related
   void process_txtrans();
   void process_txdll();
@@ -145,6 +232,11 @@ protected:
 
   int get_rxvc_bw();
 
+  /**
+   * Trace the time a request waited before entering the tx vc
+   */
+  virtual void trace_queue(cxl_req_s* req, Counter end);
+
 private:
   int m_id; /**< unique id of each endpoint */
   bool m_master; /**< endpoint is masterside when true */
@@ -152,8 +244,18 @@ private:
   pool_c<slot_s>* m_slot_pool;
   pool_c<flit_s>* m_flit_pool; /**< flit pool */
 
-  int m_lanes; /**< PCIe lanes connected to endpoint */
-  float m_perlane_bw; /**< PCIe per lane BW in GT/s */
+  pcie_link_s m_tx_link; /**< direction this endpoint sends on */
+  pcie_link_s m_rx_link; /**< direction this endpoint receives on */
+  Counter m_retimer_latency; /**< tx crossing of the retimers */
+
+  LINK_POWER_STATE m_power_state; /**< power state of the tx direction */
+  Counter m_l0p_idle; /**< idle cycles before L0p (0 : never) */
+  Counter m_l1_idle; /**< idle cycles of both directions before L1 (0 : never) */
+  Counter m_wake_latency[MAX_LINK_POWER_STATES]; /**< delay of the first flit */
+  Counter m_l0p_latency; /**< serialization of a flit over the L0p lanes */
+  Counter m_l0p_until; /**< tx serializes over the L0p lanes until this cycle */
+  Counter m_l1_wake_until; /**< the link is waking up from L1 until this cycle (both ends) */
+  double m_static_power[MAX_LINK_POWER_STATES]; /**< mW in each state */
   Counter m_prev_txphys_cycle; /**< finish cycle of previously sent packet */
 
   int m_rxvc_bw; /**< VC buffer BW */
@@ -171,6 +273,11 @@ public:
   pcie_ep_c* m_peer_ep; /**< endpoint connected to this endpoint */
   cxlsim_c* m_simBase; /**< simulation base */
   Counter m_cycle; /**< PCIe clock cycle */
+  Counter m_txphys_bits; /**< payload bits of the flits sent */
+  Counter m_txphys_flits; /**< flits sent */
+  Counter m_power_cycles[MAX_LINK_POWER_STATES]; /**< residency of the tx direction */
+  int m_trace_pid; /**< trace-event process of the component owning the endpoint */
+  int m_trace_tid; /**< trace-event thread of its tx phys */
 };
 
 } // namespace CXL
@@ -37,17 +37,47 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <cassert>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 #include "all_knobs.h"
+#include "all_stats.h"
+#include "assert_macros.h"
 #include "pcie_rc.h"
 #include "pcie_endpoint.h"
 #include "pcie_vcbuff.h"
+#include "checkpoint.h"
 
 namespace cxlsim {
 
 pcie_rc_c::pcie_rc_c(cxlsim_c* simBase) 
   : pcie_ep_c(simBase) {
-  m_pending_size = *KNOB(KNOB_PCIE_INSERTQ_SIZE);
+  m_pending_size = CFG(KNOB_PCIE_INSERTQ_SIZE);
+
+  // qos throttling
+  std::string type = *KNOB(KNOB_PCIE_QOS_THROTTLE);
+  m_qos_type = MAX_QOS_THROTTLE_TYPES;
+  for (int ii = 0; ii < MAX_QOS_THROTTLE_TYPES; ii++) {
+    if (type == qos_throttle_string[ii]) {
+      m_qos_type = static_cast<QOS_THROTTLE_TYPE>(ii);
+      break;
+    }
+  }
+  ASSERTM(m_qos_type != MAX_QOS_THROTTLE_TYPES, "unknown pcie_qos_throttle\n");
+
+  m_qos_period = CFG(KNOB_PCIE_QOS_PERIOD);
+  m_qos_rate_inc = CFG(KNOB_PCIE_QOS_RATE_INC);
+  m_qos_rate_dec = CFG(KNOB_PCIE_QOS_RATE_DEC);
+  m_qos_rate_min = CFG(KNOB_PCIE_QOS_RATE_MIN);
+  m_qos_rate_max = CFG(KNOB_PCIE_TXVC_BW);
+  ASSERTM(m_qos_period > 0, "pcie_qos_period should be positive\n");
+  ASSERTM((m_qos_rate_min > 0 && m_qos_rate_min <= m_qos_rate_max), 
+          "pcie_qos_rate_min should be in (0, pcie_txvc_bw]\n");
+
+  for (int ii = 0; ii < MAX_QOS_CLASSES; ii++) {
+    m_qos_rate[ii] = m_qos_rate_max;
+    m_qos_tokens[ii] = m_qos_rate_max;
+    m_qos_load[ii] = -1;
+  }
 }
 
 pcie_rc_c::~pcie_rc_c() {
@@ -70,15 +100,25 @@ void pcie_rc_c::run_a_cycle(bool pll_locked) {
 }
 
 void pcie_rc_c::start_transaction() {
+  update_qos();
+
   int cnt = 0;
   std::vector<cxl_req_s*> tmp_list;
   for (auto req : m_pending_req) {
+    // out of tokens : let requests of other classes go ahead
+    QOS_CLASS qos_class = get_qos_class(req);
+    if (m_qos_type != QOS_NONE && m_qos_tokens[qos_class] < 1.0) {
+      STAT_EVENT(PCIE_QOS_THROTTLED);
+      continue;
+    }
+
     bool success = push_txvc(req);
     if (success) {
       tmp_list.push_back(req);
       cnt++;
+      m_qos_tokens[qos_class] -= 1.0;
     }
-    if (cnt == *KNOB(KNOB_PCIE_TXVC_BW) || !success) {
+    if (cnt == CFG(KNOB_PCIE_TXVC_BW) || !success) {
       break;
     }
   }
@@ -89,16 +129,82 @@ void pcie_rc_c::start_transaction() {
 }
 
 void pcie_rc_c::end_transaction() {
+  // early completions first : the full completion releases the request
+  while (1) {
+    cxl_req_s* req = pull_crit_rxvc();
+    if (!req) {
+      break;
+    } else {
+      req->m_early_done = m_cycle;
+      m_early_req.push_back(req);
+    }
+  }
+
   while (1) {
     cxl_req_s* req = pull_rxvc();
     if (!req) {
       break;
     } else {
+      QOS_CLASS qos_class = get_qos_class(req);
+      m_qos_load[qos_class] = std::max(m_qos_load[qos_class], (int)req->m_devload);
+
+      if (req->m_early_done) {
+        STAT_EVENT(PCIE_CRIT_CHUNK_BASE);
+        STAT_EVENT_N(AVG_PCIE_CRIT_CHUNK_SAVING, m_cycle - req->m_early_done);
+      }
       m_done_req.push_back(req);
     }
   }
 }
 
+void pcie_rc_c::update_qos() {
+  if (m_qos_type == QOS_NONE) {
+    return;
+  }
+
+  for (int ii = 0; ii < MAX_QOS_CLASSES; ii++) {
+    m_qos_tokens[ii] = std::min(m_qos_tokens[ii] + m_qos_rate[ii], m_qos_rate_max);
+  }
+
+  if (m_cycle % m_qos_period != 0) {
+    return;
+  }
+
+  // adjust the rate by the worst load reported in this period
+  // - no response in this period : keep the rate
+  for (int ii = 0; ii < MAX_QOS_CLASSES; ii++) {
+    float rate = m_qos_rate[ii];
+    switch (m_qos_load[ii]) {
+      case DEVLOAD_LIGHT:
+        rate += m_qos_rate_inc;
+        break;
+      case DEVLOAD_MODERATE:
+        rate = (m_qos_type == QOS_AIMD) ? rate * m_qos_rate_dec 
+                                        : rate - m_qos_rate_dec;
+        break;
+      case DEVLOAD_SEVERE:
+        rate = (m_qos_type == QOS_AIMD) ? rate * m_qos_rate_dec * m_qos_rate_dec
+                                        : rate - 2 * m_qos_rate_dec;
+        break;
+      default:
+        break;
+    }
+    rate = std::max(m_qos_rate_min, std::min(rate, m_qos_rate_max));
+
+    if (rate > m_qos_rate[ii]) {
+      STAT_EVENT(PCIE_QOS_RATE_UP);
+    } else if (rate < m_qos_rate[ii]) {
+      STAT_EVENT(PCIE_QOS_RATE_DOWN);
+    }
+    m_qos_rate[ii] = rate;
+    m_qos_load[ii] = -1;
+  }
+}
+
+QOS_CLASS pcie_rc_c::get_qos_class(cxl_req_s* req) {
+  return req->m_write ? QOS_CLASS_WRITE : QOS_CLASS_READ;
+}
+
 void pcie_rc_c::insert_request(cxl_req_s* req) {
   assert((int)m_pending_req.size() < m_pending_size);
   m_pending_req.push_back(req);
@@ -111,6 +217,10 @@ bool pcie_rc_c::rootcomplex_full() {
     return false;
 }
 
+int pcie_rc_c::pending_size() {
+  return (int)m_pending_req.size();
+}
+
 cxl_req_s* pcie_rc_c::pop_request() {
   if (m_done_req.empty()) {
     return NULL;
@@ -121,6 +231,26 @@ cxl_req_s* pcie_rc_c::pop_request() {
   }
 }
 
+cxl_req_s* pcie_rc_c::pop_early_request() {
+  if (m_early_req.empty()) {
+    return NULL;
+  } else {
+    cxl_req_s* req = m_early_req.front();
+    m_early_req.pop_front();
+    return req;
+  }
+}
+
+void pcie_rc_c::checkpoint(checkpoint_c* ckpt) {
+  pcie_ep_c::checkpoint(ckpt);
+  ckpt->io(m_pending_req);
+  ckpt->io(m_done_req);
+  ckpt->io(m_early_req);
+  ckpt->io(m_qos_rate);
+  ckpt->io(m_qos_tokens);
+  ckpt->io(m_qos_load);
+}
+
 void pcie_rc_c::print_rc_info() {
   std::cout << "-------------- Root Complex ------------------" << std::endl;
   print_ep_info();
@@ -130,6 +260,14 @@ void pcie_rc_c::print_rc_info() {
 /* std::cout << std::hex << req->m_addr << " ; "; */
 /* } */
 
+  if (m_qos_type != QOS_NONE) {
+    std::cout << "qos rate" << ": ";
+    for (int ii = 0; ii < MAX_QOS_CLASSES; ii++) {
+      std::cout << m_qos_rate[ii] << " ; ";
+    }
+    std::cout << std::endl;
+  }
+
   std::cout << "done q" << ": ";
   for (auto req : m_done_req) {
     std::cout << req->m_addr << " ; ";
@@ -38,12 +38,34 @@ POSSIBILITY OF SUCH DAMAGE.
 #define PCIE_RC_H
 
 #include <list>
+#include <string>
 
 #include "pcie_endpoint.h"
 #include "global_defs.h"
 
 namespace cxlsim {
 
+// issue rate throttling algorithm driven by the DevLoad of responses
+typedef enum QOS_THROTTLE_TYPE {
+  QOS_NONE = 0,
+  QOS_AIMD, /**< additive increase, multiplicative decrease */
+  QOS_STEP, /**< fixed step per load level */
+  MAX_QOS_THROTTLE_TYPES
+} QOS_THROTTLE_TYPE;
+
+static const std::string qos_throttle_string[MAX_QOS_THROTTLE_TYPES] = {
+  "none",
+  "aimd",
+  "step"
+};
+
+// requests are throttled separately per QoS class
+typedef enum QOS_CLASS {
+  QOS_CLASS_READ = 0,
+  QOS_CLASS_WRITE,
+  MAX_QOS_CLASSES
+} QOS_CLASS;
+
 class pcie_rc_c : public pcie_ep_c 
 {
 public:
@@ -69,11 +91,26 @@ public:
 
   bool rootcomplex_full();
 
+  /**
+   * Number of requests waiting to be issued
+   */
+  int pending_size();
+
   /**
    * Pop a finished pcie request
    */
   cxl_req_s* pop_request();
 
+  /**
+   * Pop a request whose critical chunk arrived (early completion)
+   */
+  cxl_req_s* pop_early_request();
+
+  /**
+   * Save or restore the state
+   */
+  void checkpoint(checkpoint_c* ckpt) override;
+
   /**
    * Print for debugging
    */
@@ -90,10 +127,32 @@ private:
    */
   void end_transaction() override;
 
+  /**
+   * Refill issue tokens & adjust the issue rate at the end of each period
+   */
+  void update_qos();
+
+  /**
+   * Get QoS class of a request
+   */
+  QOS_CLASS get_qos_class(cxl_req_s* req);
+
 private:
   int m_pending_size; /**< size of pending queue */
   std::list<cxl_req_s*> m_pending_req; /**< requests pending */
   std::list<cxl_req_s*> m_done_req;    /**< requests finished */
+  std::list<cxl_req_s*> m_early_req;   /**< requests with critical chunk arrived */
+
+  // qos throttling
+  QOS_THROTTLE_TYPE m_qos_type; /**< throttling algorithm */
+  int m_qos_period; /**< cycles between rate updates */
+  float m_qos_rate_inc; /**< rate increment */
+  float m_qos_rate_dec; /**< rate decrement (aimd : multiplier) */
+  float m_qos_rate_min; /**< minimum issue rate (reqs/cycle) */
+  float m_qos_rate_max; /**< maximum issue rate (reqs/cycle) */
+  float m_qos_rate[MAX_QOS_CLASSES]; /**< current issue rate */
+  float m_qos_tokens[MAX_QOS_CLASSES]; /**< issue tokens */
+  int m_qos_load[MAX_QOS_CLASSES]; /**< worst devload in this period (-1 : none) */
 };
 
 }
@@ -39,6 +39,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <algorithm>
 
 #include "pcie_vcbuff.h"
+#include "checkpoint.h"
+#include "sim_profile.h"
 
 #include "utils.h"
 #include "all_knobs.h"
@@ -47,10 +49,6 @@ POSSIBILITY OF SUCH DAMAGE.
 
 namespace cxlsim {
 
-int vc_buff_c::m_msg_uid;
-int vc_buff_c::m_slot_uid;
-int vc_buff_c::m_flit_uid;
-
 vc_buff_c::vc_buff_c(cxlsim_c* simBase) {
   m_simBase = simBase;
   m_cycle = 0;
@@ -73,6 +71,7 @@ void vc_buff_c::init(bool is_tx, bool is_master,
   m_flit_pool = flit_pool;
   m_channel_cap = chan_cap;
   m_flitbuff_cap = flitbuff_cap;
+  m_crit_first = CFG(KNOB_PCIE_CRITICAL_CHUNK_FIRST);
 
   m_hslot_msg_limit[M2S_REQ] = 1;
   m_hslot_msg_limit[M2S_RWD] = 1;
@@ -137,15 +136,42 @@ message_s* vc_buff_c::pull_msg(int vc_id) {
       continue;
     }
     remove_msg(msg);
+
+    // the full response is out before its critical chunk got through the
+    // transaction layer : nothing to complete early
+    for (auto iter = m_crit_done.begin(); iter != m_crit_done.end(); ++iter) {
+      if (iter->first == msg->m_req) {
+        m_crit_done.erase(iter);
+        break;
+      }
+    }
     return msg;
   }
   return NULL;
 }
 
+cxl_req_s* vc_buff_c::pull_crit_req() {
+  assert(!m_istx);
+  for (auto iter = m_crit_done.begin(); iter != m_crit_done.end(); ++iter) {
+    if (iter->second <= m_cycle) {
+      cxl_req_s* req = iter->first;
+      m_crit_done.erase(iter);
+      return req;
+    }
+  }
+  return NULL;
+}
+
 void vc_buff_c::receive_flit(flit_s* flit) {
   for (auto slot : flit->m_slots) {
     for (auto msg : slot->m_msgs) {
       if (msg->m_data) {
+        // critical chunk landed : the host can resume once the header is
+        // through the transaction layer, before the rest of the line arrives
+        if (m_crit_first && msg->m_critical) {
+          m_crit_done.push_back({msg->m_parent->m_req, 
+                                 std::max(m_cycle, msg->m_parent->m_rxvc_insert_done)});
+        }
         msg->m_parent->inc_arrived_child();
         release_msg(msg);
       } else {
@@ -162,6 +188,8 @@ void vc_buff_c::run_a_cycle() {
 }
 
 void vc_buff_c::generate_flits() {
+  PROFILE_SCOPE(m_simBase->m_profile, PROF_GEN_FLITS);
+
   assert(m_istx);
 
   std::list<message_s*> rdy;
@@ -191,7 +219,7 @@ void vc_buff_c::generate_flits() {
       }
     } 
     // no rollover but not full : push general slot to back
-    else if (back_flit->num_slots() < *KNOB(KNOB_PCIE_SLOTS_PER_FLIT)) {
+    else if (back_flit->num_slots() < CFG(KNOB_PCIE_SLOTS_PER_FLIT)) {
       auto gslot = generate_gslot(rdy, back_flit);
       if (gslot != NULL) {
         back_flit->push_back(gslot);
@@ -212,7 +240,7 @@ void vc_buff_c::generate_new_flit(std::list<message_s*>& msgs) {
     new_flit = acquire_flit();
     new_flit->push_back(hslot);
 
-    for (int ii = 0; ii < *KNOB(KNOB_PCIE_SLOTS_PER_FLIT) - 1; ii++) {
+    for (int ii = 0; ii < CFG(KNOB_PCIE_SLOTS_PER_FLIT) - 1; ii++) {
       if ((int)msgs.size() == 0) {
         break;
       }
@@ -236,15 +264,7 @@ void vc_buff_c::add_data_slots_and_insert(flit_s* flit, slot_s* slot) {
     if (!msg->is_wdata_msg()) {
       continue;
     }
-    for (int ii = 0; ii < *KNOB(KNOB_PCIE_SLOTS_PER_FLIT); ii++) {
-      auto data_msg = acquire_message(DATA_CHANNEL, NULL);
-      data_msg->init_data_msg(msg);
-
-      auto data_slot = acquire_slot();
-      data_slot->push_back(data_msg);
-      data_slot->assign_type();
-      data_slots.push_back(data_slot);
-    }
+    generate_data_slots(msg, data_slots);
   }
 
   insert_data_slots(flit, data_slots);
@@ -257,25 +277,42 @@ void vc_buff_c::add_data_slots_and_insert(flit_s* flit) {
       if (!msg->is_wdata_msg()) {
         continue;
       }
-      for (int ii = 0; ii < *KNOB(KNOB_PCIE_SLOTS_PER_FLIT); ii++) {
-        auto data_msg = acquire_message(DATA_CHANNEL, NULL);
-        data_msg->init_data_msg(msg);
-
-        auto data_slot = acquire_slot();
-        data_slot->push_back(data_msg);
-        data_slot->assign_type();
-        data_slots.push_back(data_slot);
-      }
+      generate_data_slots(msg, data_slots);
     }
   }
 
   insert_data_slots(flit, data_slots);
 }
 
+// one data slot per chunk of the cacheline. with critical chunk first,
+// the chunk holding the requested address of a DRS goes in the first
+// data slot and the rest follow in wrap-around order
+void vc_buff_c::generate_data_slots(message_s* msg, 
+                                    std::list<slot_s*>& data_slots) {
+  int chunks = CFG(KNOB_PCIE_SLOTS_PER_FLIT);
+  int crit = 0;
+  if (msg->m_type == S2M_DRS) {
+    int chunk_bytes = CFG(KNOB_PCIE_DATA_MSG_BITS) / 8;
+    crit = (int)((msg->m_req->m_addr / chunk_bytes) % chunks);
+  }
+
+  for (int ii = 0; ii < chunks; ii++) {
+    auto data_msg = acquire_message(DATA_CHANNEL, NULL);
+    data_msg->init_data_msg(msg);
+    data_msg->m_chunk = m_crit_first ? (crit + ii) % chunks : ii;
+    data_msg->m_critical = (msg->m_type == S2M_DRS && data_msg->m_chunk == crit);
+
+    auto data_slot = acquire_slot();
+    data_slot->push_back(data_msg);
+    data_slot->assign_type();
+    data_slots.push_back(data_slot);
+  }
+}
+
 void vc_buff_c::insert_data_slots(flit_s* flit, std::list<slot_s*>& data_slots) {
   flit_s* new_flit = NULL;
   for (auto data_slot : data_slots) {
-    if (flit->num_slots() < *KNOB(KNOB_PCIE_SLOTS_PER_FLIT)) {
+    if (flit->num_slots() < CFG(KNOB_PCIE_SLOTS_PER_FLIT)) {
       flit->push_back(data_slot);
     } else {
       if (new_flit == NULL) {
@@ -285,7 +322,7 @@ void vc_buff_c::insert_data_slots(flit_s* flit, std::list<slot_s*>& data_slots)
       new_flit->push_back(data_slot);
       new_flit->m_flit_gen_cycle = m_cycle;
 
-      if (new_flit->num_slots() == *KNOB(KNOB_PCIE_SLOTS_PER_FLIT)) {
+      if (new_flit->num_slots() == CFG(KNOB_PCIE_SLOTS_PER_FLIT)) {
         m_flit_buff.push_back(new_flit);
         new_flit = NULL;
       }
@@ -303,7 +340,7 @@ slot_s* vc_buff_c::generate_hslot(std::list<message_s*>& msgs) {
   // wait for a certain period before inserting into a flit
   auto msg = msgs.front();
   if ((m_cycle - msg->m_txvc_insert_done) < 
-        *KNOB(KNOB_PCIE_MAX_FLIT_WAIT_CYCLE)) { 
+        CFG(KNOB_PCIE_MAX_FLIT_WAIT_CYCLE)) { 
     return NULL;
   }
 
@@ -397,12 +434,13 @@ bool vc_buff_c::check_valid_general(slot_s* slot, message_s* msg, flit_s* flit)
 void vc_buff_c::insert_channel(int vc_id, message_s* msg) {
   m_channel_cnt[msg->m_vc_id]++;
   m_msg_buff.push_back(msg);
+  STAT_EVENT(PCIE_VCBUFF_MSGS);
   if (m_istx) {
     msg->m_txvc_insert_start = m_cycle;
-    msg->m_txvc_insert_done = m_cycle + *KNOB(KNOB_PCIE_TXTRANS_LATENCY);
+    msg->m_txvc_insert_done = m_cycle + CFG(KNOB_PCIE_TXTRANS_LATENCY);
   } else {
     msg->m_rxvc_insert_start = m_cycle;
-    msg->m_rxvc_insert_done = m_cycle + *KNOB(KNOB_PCIE_RXTRANS_LATENCY);
+    msg->m_rxvc_insert_done = m_cycle + CFG(KNOB_PCIE_RXTRANS_LATENCY);
   }
 }
 
@@ -431,7 +469,7 @@ message_s* vc_buff_c::acquire_message(int vc_id, cxl_req_s* req) {
   message_s* msg = m_msg_pool->acquire_entry(m_simBase);
 
   msg->init();
-  msg->m_id = ++m_msg_uid;
+  msg->m_id = ++m_simBase->m_msg_uid;
   msg->m_vc_id = vc_id;
   msg->m_req = req;
 
@@ -439,15 +477,15 @@ message_s* vc_buff_c::acquire_message(int vc_id, cxl_req_s* req) {
     switch (vc_id) {
       case WOD_CHANNEL:
         msg->m_type = M2S_REQ;
-        msg->m_bits = *KNOB(KNOB_PCIE_REQ_MSG_BITS);
+        msg->m_bits = CFG(KNOB_PCIE_REQ_MSG_BITS);
         break;
       case WD_CHANNEL:
         msg->m_type = M2S_RWD;
-        msg->m_bits = *KNOB(KNOB_PCIE_RWD_MSG_BITS);
+        msg->m_bits = CFG(KNOB_PCIE_RWD_MSG_BITS);
         break;
       case DATA_CHANNEL:
         msg->m_type = M2S_DATA;
-        msg->m_bits = *KNOB(KNOB_PCIE_DATA_MSG_BITS);
+        msg->m_bits = CFG(KNOB_PCIE_DATA_MSG_BITS);
         break;
       default:
         assert(0);
@@ -457,15 +495,15 @@ message_s* vc_buff_c::acquire_message(int vc_id, cxl_req_s* req) {
     switch (vc_id) {
       case WOD_CHANNEL:
         msg->m_type = S2M_NDR;
-        msg->m_bits = *KNOB(KNOB_PCIE_NDR_MSG_BITS);
+        msg->m_bits = CFG(KNOB_PCIE_NDR_MSG_BITS);
         break;
       case WD_CHANNEL:
         msg->m_type = S2M_DRS;
-        msg->m_bits = *KNOB(KNOB_PCIE_DRS_MSG_BITS);
+        msg->m_bits = CFG(KNOB_PCIE_DRS_MSG_BITS);
         break;
       case DATA_CHANNEL:
         msg->m_type = S2M_DATA;
-        msg->m_bits = *KNOB(KNOB_PCIE_DATA_MSG_BITS);
+        msg->m_bits = CFG(KNOB_PCIE_DATA_MSG_BITS);
         break;
       default:
         assert(0);
@@ -478,33 +516,41 @@ message_s* vc_buff_c::acquire_message(int vc_id, cxl_req_s* req) {
 slot_s* vc_buff_c::acquire_slot() {
   slot_s* new_slot = m_slot_pool->acquire_entry(m_simBase);
   new_slot->init();
-  new_slot->m_id = ++m_slot_uid;
+  new_slot->m_id = ++m_simBase->m_slot_uid;
   return new_slot;
 }
 
 flit_s* vc_buff_c::acquire_flit() {
   flit_s* new_flit = m_flit_pool->acquire_entry(m_simBase);
   new_flit->init();
-  new_flit->m_id = ++m_flit_uid;
+  new_flit->m_id = ++m_simBase->m_flit_uid;
   return new_flit;
 }
 
 void vc_buff_c::forward_progress_check() {
   for (auto msg : m_msg_buff) {
     if (m_istx) {
-      assert(m_cycle - msg->m_txvc_insert_start <= *KNOB(KNOB_PROGRESS_LIMIT));
+      assert(m_cycle - msg->m_txvc_insert_start <= CFG(KNOB_PROGRESS_LIMIT));
     } else {
-      assert(m_cycle - msg->m_rxvc_insert_start <= *KNOB(KNOB_PROGRESS_LIMIT));
+      assert(m_cycle - msg->m_rxvc_insert_start <= CFG(KNOB_PROGRESS_LIMIT));
     }
   }
 
   for (auto flit : m_flit_buff) {
     if (m_istx) {
-      assert(m_cycle - flit->m_flit_gen_cycle <= *KNOB(KNOB_PROGRESS_LIMIT));
+      assert(m_cycle - flit->m_flit_gen_cycle <= CFG(KNOB_PROGRESS_LIMIT));
     }
   }
 }
 
+void vc_buff_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_msg_buff);
+  ckpt->io(m_flit_buff);
+  ckpt->io(m_crit_done);
+  ckpt->io(m_channel_cnt);
+  ckpt->io(m_cycle);
+}
+
 void vc_buff_c::print() {
   for (auto msg : m_msg_buff) {
     msg->print();
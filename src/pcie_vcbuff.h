@@ -39,6 +39,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <list>
 #include <deque>
+#include <utility>
 
 #include "packet_info.h"
 #include "cxlsim.h"
@@ -63,9 +64,11 @@ public:
   flit_s* peek_flit(); 
   void pop_flit(); /**< pop a flit from m_flit_buff */
   message_s* pull_msg(int vc_id); /**< pull msg from rxvc */
+  cxl_req_s* pull_crit_req(); /**< pull req whose critical chunk arrived */
   void receive_flit(flit_s* flit); /**< receive flit from rxphys */
   void run_a_cycle(); /**< run a cycle */
   void generate_flits(); /**< look at vc buffers and generate a flit */
+  void checkpoint(checkpoint_c* ckpt); /**< save or restore the state */
   void print();
 
 private:
@@ -85,15 +88,11 @@ private:
   bool check_valid_general(slot_s* slot, message_s* msg, flit_s* flit); /**< check limit conditions for general flit */
   void add_data_slots_and_insert(flit_s* flit);
   void add_data_slots_and_insert(flit_s* flit, slot_s* slot);
+  void generate_data_slots(message_s* msg, std::list<slot_s*>& data_slots);
   void insert_data_slots(flit_s* flit, std::list<slot_s*>& data_slots);
 
   void forward_progress_check();
 
-public:
-  static int m_msg_uid;
-  static int m_slot_uid;
-  static int m_flit_uid;
-
 private:
   pool_c<message_s>* m_msg_pool;
   pool_c<slot_s>* m_slot_pool;
@@ -102,6 +101,9 @@ private:
   std::list<message_s*> m_msg_buff;
   std::list<flit_s*> m_flit_buff;
 
+  bool m_crit_first; /**< send the critical chunk of a DRS first */
+  std::list<std::pair<cxl_req_s*, Counter>> m_crit_done; /**< early completions */
+
   int m_channel_cnt[MAX_CHANNEL];
   int m_channel_cap; /**< channel capacity */
   int m_flitbuff_cap;
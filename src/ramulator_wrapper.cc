@@ -2,7 +2,10 @@
 
 #ifdef RAMULATOR
 
+#include <cstdio>
+#include <fstream>
 #include <map>
+#include <mutex>
 
 #include "ramulator/src/Config.h"
 #include "ramulator/src/DDR3.h"
@@ -20,6 +23,7 @@
 #include "ramulator/src/WideIO2.h"
 
 #include "ramulator_wrapper.h"
+#include "assert_macros.h"
 
 namespace ramulator {
 
@@ -37,32 +41,120 @@ static std::map<std::string, function<MemoryBase *(const Config &, int)>> name_t
   {"SALP-MASA", &MemoryFactory<SALP>::create},
 };
 
+// ramulator registers the stats of every memory in the process-wide
+// Stats::statlist. memories are created & deleted one at a time, and the
+// list is printed only if the process ever held a single memory : with more
+// (several mxps or cxlsim instances) it would mix their stats & reach the
+// stats of memories already deleted
+static std::mutex statlist_mutex;
+static int statlist_memories = 0;
+static bool statlist_warned = false;
+
 CXLRamulatorWrapper::CXLRamulatorWrapper(const Config &configs, int cacheline, 
-    std::string statout) {
+    std::string statout, std::string cmd_trace) 
+  : trace_configs(configs), cmd_trace(cmd_trace) {
+  std::lock_guard<std::mutex> lock(statlist_mutex);
+  statlist_memories++;
+
+  // each controller writes the commands of its ranks (DRAMPower format) to
+  // <cmd_trace>chan-<channel>-rank-<rank>.cmdtrace
+  if (!cmd_trace.empty()) {
+    trace_configs.add("record_cmd_trace", "on");
+    trace_configs.add("cmd_trace_prefix", cmd_trace);
+    ASSERTM((trace_configs["record_cmd_trace"] == "on" && 
+             trace_configs["cmd_trace_prefix"] == cmd_trace), 
+            "the ramulator config should not set the command trace options\n");
+  }
+
   // FIXME : statlist is declared inside src/ramulator/src/StatType.{cc & h}
 /* Stats::statlist.output(statout); */
-  const std::string &std_name = configs["standard"];
+  const std::string &std_name = trace_configs["standard"];
   assert(name_to_func.find(std_name) != name_to_func.end() &&
          "unrecognized standard name");
-  mem = name_to_func[std_name](configs, cacheline);
+  mem = name_to_func[std_name](trace_configs, cacheline);
   tCK = mem->clk_ns();
 }
 
 CXLRamulatorWrapper::~CXLRamulatorWrapper() {
-  Stats::statlist.printall();
+  release();
+}
+
+void CXLRamulatorWrapper::release() {
+  if (mem == NULL) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(statlist_mutex);
+  if (statlist_memories == 1) {
+    Stats::statlist.printall();
+  } else if (!statlist_warned) {
+    fprintf(stderr, "warning: ramulator stats are not printed with %d dram "
+            "models in the process\n", statlist_memories);
+    statlist_warned = true;
+  }
   delete mem;
+  mem = NULL;
 }
 
+// count_commands closes the dram : it takes no more requests after that
 void CXLRamulatorWrapper::tick() {
-  mem->tick();
+  if (mem != NULL) {
+    mem->tick();
+  }
 }
 
 bool CXLRamulatorWrapper::send(Request req) {
+  if (mem == NULL) {
+    return false;
+  }
   return mem->send(req);
 }
 
+int CXLRamulatorWrapper::pending_requests() {
+  if (mem == NULL) {
+    return 0;
+  }
+  return mem->pending_requests();
+}
+
 void CXLRamulatorWrapper::finish(void) {
-  mem->finish();
+  if (mem != NULL) {
+    mem->finish();
+  }
+}
+
+// the trace files are flushed only when the controllers are deleted
+void CXLRamulatorWrapper::count_commands(std::map<std::string, long> &counts) {
+  release();
+  if (cmd_trace.empty()) {
+    return;
+  }
+
+  // every rank of every channel has a trace from the start (see Controller)
+  for (int channel = 0; channel < trace_configs.get_channels(); ++channel) {
+    for (int rank = 0; rank < trace_configs.get_ranks(); ++rank) {
+      std::string path = cmd_trace + "chan-" + std::to_string(channel) + 
+                         "-rank-" + std::to_string(rank) + ".cmdtrace";
+      std::ifstream file(path);
+      ASSERTM(file.is_open(), "dram command trace missing (dram_energy_enable)\n");
+
+      // cycle,command[,bank]
+      std::string line;
+      while (std::getline(file, line)) {
+        std::size_t begin = line.find(',');
+        if (begin == std::string::npos) {
+          continue;
+        }
+        std::size_t end = line.find(',', begin + 1);
+        if (end == std::string::npos) {
+          end = line.size();
+        }
+        counts[line.substr(begin + 1, end - begin - 1)]++;
+      }
+      file.close();
+      std::remove(path.c_str());
+    }
+  }
 }
 
 } // namespace ramulator
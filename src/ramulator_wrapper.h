@@ -5,6 +5,7 @@
 
 #ifdef RAMULATOR
 
+#include <map>
 #include <string>
 
 #include "ramulator/src/Config.h"
@@ -19,14 +20,24 @@ class CXLRamulatorWrapper
 {
 private:
   MemoryBase *mem;
+  Config trace_configs; // configs with the command trace options
+  std::string cmd_trace; // command trace prefix (empty : no trace)
+
+  void release();
 
 public:
   double tCK;
-  CXLRamulatorWrapper(const Config &configs, int cacheline, std::string statout);
+  CXLRamulatorWrapper(const Config &configs, int cacheline, std::string statout,
+                      std::string cmd_trace = "");
   ~CXLRamulatorWrapper();
   void tick();
   bool send(Request req);
+  int pending_requests();
   void finish(void);
+
+  // close the memory (tick/send do nothing afterwards) & count the commands
+  // of the trace by name (ACT, RD, ...)
+  void count_commands(std::map<std::string, long> &counts);
 };
 
 } /*namespace ramulator*/
@@ -0,0 +1,288 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : sampler.cc
+ * Description  : Statistical sampling (functional fast-forward, warm-up & measured windows)
+ *********************************************************************************************/
+
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include "sampler.h"
+#include "checkpoint.h"
+#include "cxlsim.h"
+#include "pcie_rc.h"
+#include "assert_macros.h"
+
+#include "all_knobs.h"
+#include "all_stats.h"
+#include "statistics.h"
+
+namespace cxlsim {
+
+sample_stat_s::sample_stat_s() {
+  m_n = 0;
+  m_mean = 0.0;
+  m_m2 = 0.0;
+}
+
+void sample_stat_s::add(double value) {
+  m_n++;
+  double delta = value - m_mean;
+  m_mean += delta / m_n;
+  m_m2 += delta * (value - m_mean);
+}
+
+double sample_stat_s::half_width(double z) const {
+  if (m_n < 2) {
+    return 0.0;
+  }
+  double var = m_m2 / (m_n - 1);
+  return z * std::sqrt(var / m_n);
+}
+
+double sample_stat_s::rel_error(double z) const {
+  return m_mean > 0.0 ? half_width(z) / m_mean : 0.0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// z with P(|N(0,1)| < z) = conf, by bisection
+static double normal_quantile(double conf) {
+  double lo = 0.0;
+  double hi = 10.0;
+  for (int ii = 0; ii < 64; ++ii) {
+    double mid = 0.5 * (lo + hi);
+    if (std::erf(mid / std::sqrt(2.0)) < conf) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0.5 * (lo + hi);
+}
+
+sampler_c::sampler_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  m_period = CFG(KNOB_SAMPLE_PERIOD);
+  m_warmup = CFG(KNOB_SAMPLE_WARMUP);
+  m_window = CFG(KNOB_SAMPLE_WINDOW);
+  m_fastfwd = m_period - m_warmup - m_window;
+  m_min_windows = CFG(KNOB_SAMPLE_MIN_WINDOWS);
+  m_target_error = CFG(KNOB_SAMPLE_TARGET_ERROR);
+  m_freq = CFG(KNOB_CLOCK_IO);
+  m_cycle = 0;
+  m_measuring = false;
+  m_done = false;
+  m_cur = sample_window_s();
+  m_lat_sum[0] = m_lat_sum[1] = 0;
+  m_start_m2s_bits = 0;
+  m_start_s2m_bits = 0;
+
+  double conf = CFG(KNOB_SAMPLE_CONFIDENCE);
+  ASSERTM(conf > 0.0 && conf < 1.0, "sample_confidence must be in (0, 1)\n");
+  m_z = normal_quantile(conf);
+
+  if (!enabled()) {
+    return;
+  }
+
+  ASSERTM(m_window > 0 && m_warmup >= 0 && m_fastfwd >= 0,
+          "sample_period must cover sample_warmup + sample_window\n");
+
+  // no fast-forward & warm-up : the first window opens at cycle 0
+  if (phase() == SAMPLE_MEASURE) {
+    start_window();
+  }
+}
+
+sampler_c::~sampler_c() {
+}
+
+bool sampler_c::enabled() {
+  return m_period > 0;
+}
+
+bool sampler_c::fast_forward() {
+  return enabled() && phase() == SAMPLE_FASTFWD;
+}
+
+bool sampler_c::done() {
+  return m_done;
+}
+
+void sampler_c::record_latency(bool write, Counter latency) {
+  if (m_measuring) {
+    m_cur.m_reqs[write]++;
+    m_lat_sum[write] += latency;
+  }
+}
+
+void sampler_c::run_a_cycle() {
+  m_cycle++;
+
+  // the measured window is the tail of a period
+  if (m_measuring && m_cycle % m_period == 0) {
+    end_window();
+  }
+  if (!m_measuring && phase() == SAMPLE_MEASURE) {
+    start_window();
+  }
+}
+
+SAMPLE_PHASE sampler_c::phase() {
+  int pos = m_cycle % m_period;
+  if (pos < m_fastfwd) {
+    return SAMPLE_FASTFWD;
+  } else if (pos < m_fastfwd + m_warmup) {
+    return SAMPLE_WARMUP;
+  } else {
+    return SAMPLE_MEASURE;
+  }
+}
+
+void sampler_c::link_bits(Counter* m2s_bits, Counter* s2m_bits) {
+  *m2s_bits = 0;
+  *s2m_bits = 0;
+  for (auto rc : m_simBase->m_rcs) {
+    *m2s_bits += rc->m_txphys_bits;
+    *s2m_bits += rc->m_peer_ep->m_txphys_bits;
+  }
+}
+
+void sampler_c::start_window() {
+  m_measuring = true;
+  m_cur.m_reqs[0] = m_cur.m_reqs[1] = 0;
+  m_lat_sum[0] = m_lat_sum[1] = 0;
+  link_bits(&m_start_m2s_bits, &m_start_s2m_bits);
+}
+
+void sampler_c::end_window() {
+  m_measuring = false;
+
+  Counter m2s_bits, s2m_bits;
+  link_bits(&m2s_bits, &s2m_bits);
+
+  // bits per io cycle * cycles per ns = Gb/s
+  m_cur.m_cycle = m_cycle;
+  m_cur.m_value[SAMPLE_M2S_BW] = (m2s_bits - m_start_m2s_bits) * m_freq / m_window;
+  m_cur.m_value[SAMPLE_S2M_BW] = (s2m_bits - m_start_s2m_bits) * m_freq / m_window;
+  m_stats[SAMPLE_M2S_BW].add(m_cur.m_value[SAMPLE_M2S_BW]);
+  m_stats[SAMPLE_S2M_BW].add(m_cur.m_value[SAMPLE_S2M_BW]);
+
+  // a window without reads (writes) has no read (write) latency sample
+  for (int write = 0; write < 2; ++write) {
+    SAMPLE_METRIC metric = write ? SAMPLE_WRITE_LATENCY : SAMPLE_READ_LATENCY;
+    m_cur.m_value[metric] = 0.0;
+    if (m_cur.m_reqs[write] > 0) {
+      m_cur.m_value[metric] = 1.0 * m_lat_sum[write] / m_cur.m_reqs[write];
+      m_stats[metric].add(m_cur.m_value[metric]);
+    }
+  }
+
+  m_windows.push_back(m_cur);
+  STAT_EVENT(SAMPLE_WINDOWS);
+
+  m_done = converged();
+}
+
+bool sampler_c::converged() {
+  if (m_target_error <= 0.0 || (int)m_windows.size() < m_min_windows) {
+    return false;
+  }
+
+  // metrics seen in less than two windows carry no error estimate
+  for (int ii = 0; ii < MAX_SAMPLE_METRICS; ++ii) {
+    if (m_stats[ii].m_n >= 2 && m_stats[ii].rel_error(m_z) > m_target_error) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void sampler_c::finalize() {
+  if (!enabled()) {
+    return;
+  }
+
+  std::cout << "Sampling : " << m_windows.size() << " windows, "
+            << (m_done ? "target error reached" : "target error not reached")
+            << std::endl;
+  for (int ii = 0; ii < MAX_SAMPLE_METRICS; ++ii) {
+    const sample_stat_s& stat = m_stats[ii];
+    std::cout << std::fixed << std::setprecision(2) << "  " 
+              << sample_metric_string[ii] << " : " << stat.m_mean 
+              << " +- " << stat.half_width(m_z) 
+              << " (" << 100.0 * stat.rel_error(m_z) << "%)" << std::endl;
+  }
+  std::cout.unsetf(std::ios_base::floatfield);
+
+  std::ofstream* stream = m_simBase->get_output_stream("sample.stat.out");
+  if (stream == NULL) {
+    return;
+  }
+
+  std::ofstream& out = *stream;
+  out << "metric,windows,mean,half_width,rel_error,confidence" << std::endl;
+  for (int ii = 0; ii < MAX_SAMPLE_METRICS; ++ii) {
+    const sample_stat_s& stat = m_stats[ii];
+    out << std::fixed << std::setprecision(4) << sample_metric_string[ii] << ","
+        << stat.m_n << "," << stat.m_mean << "," << stat.half_width(m_z) << ","
+        << stat.rel_error(m_z) << "," << CFG(KNOB_SAMPLE_CONFIDENCE) << std::endl;
+  }
+
+  out << std::endl << "cycle,rd_done,wr_done";
+  for (int ii = 0; ii < MAX_SAMPLE_METRICS; ++ii) {
+    out << "," << sample_metric_string[ii];
+  }
+  out << std::endl;
+  for (auto& window : m_windows) {
+    out << std::fixed << std::setprecision(2) << window.m_cycle << ","
+        << window.m_reqs[0] << "," << window.m_reqs[1];
+    for (int ii = 0; ii < MAX_SAMPLE_METRICS; ++ii) {
+      out << "," << window.m_value[ii];
+    }
+    out << std::endl;
+  }
+}
+
+void sampler_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_cycle);
+  ckpt->io(m_measuring);
+  ckpt->io(m_done);
+  ckpt->io(m_cur);
+  ckpt->io(m_lat_sum);
+  ckpt->io(m_start_m2s_bits);
+  ckpt->io(m_start_s2m_bits);
+  ckpt->io(m_windows);
+  ckpt->io(m_stats);
+}
+
+} // namespace CXL
@@ -0,0 +1,172 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : sampler.h
+ * Description  : Statistical sampling (functional fast-forward, warm-up & measured windows)
+ *********************************************************************************************/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <string>
+#include <vector>
+
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+// phases of a sampling period
+typedef enum SAMPLE_PHASE {
+  SAMPLE_FASTFWD = 0, /**< requests complete functionally, detailed model drains */
+  SAMPLE_WARMUP,      /**< detailed simulation, not measured */
+  SAMPLE_MEASURE,     /**< detailed simulation, measured */
+  MAX_SAMPLE_PHASES
+} SAMPLE_PHASE;
+
+// metrics estimated from the measured windows
+typedef enum SAMPLE_METRIC {
+  SAMPLE_READ_LATENCY = 0, /**< average read latency (io cycles) */
+  SAMPLE_WRITE_LATENCY,    /**< average write latency (io cycles) */
+  SAMPLE_M2S_BW,           /**< m2s link bandwidth (Gb/s) */
+  SAMPLE_S2M_BW,           /**< s2m link bandwidth (Gb/s) */
+  MAX_SAMPLE_METRICS
+} SAMPLE_METRIC;
+
+static const std::string sample_metric_string[MAX_SAMPLE_METRICS] = {
+  "read_latency",
+  "write_latency",
+  "m2s_gbps",
+  "s2m_gbps"
+};
+
+// running mean & variance of the per-window values (welford)
+typedef struct sample_stat_s {
+  sample_stat_s();
+  void add(double value);
+  double half_width(double z) const; /**< confidence interval half width */
+  double rel_error(double z) const; /**< half width / mean */
+
+  Counter m_n; /**< windows with a value */
+  double m_mean; /**< mean of the window values */
+  double m_m2; /**< sum of squared differences from the mean */
+} sample_stat_s;
+
+// one measured window
+typedef struct sample_window_s {
+  Counter m_cycle; /**< io cycle at the end of the window */
+  Counter m_reqs[2]; /**< finished reads & writes */
+  double m_value[MAX_SAMPLE_METRICS]; /**< metrics (latency only with requests) */
+} sample_window_s;
+
+// smarts-style sampling : every sample_period io cycles the outer requests
+// are fast-forwarded functionally, then the detailed model warms up for
+// sample_warmup cycles & is measured for sample_window cycles. the per-window
+// metrics are the sample for estimates with confidence intervals
+class sampler_c {
+public:
+  /**
+   * Constructor
+   */
+  sampler_c(cxlsim_c* simBase);
+
+  /**
+   * Destructor
+   */
+  ~sampler_c();
+
+  /**
+   * Returns true if sampling is enabled
+   */
+  bool enabled();
+
+  /**
+   * Requests inserted in the current cycle complete functionally
+   */
+  bool fast_forward();
+
+  /**
+   * The estimates reached the target error
+   */
+  bool done();
+
+  /**
+   * Record end-to-end latency of a finished request
+   */
+  void record_latency(bool write, Counter latency);
+
+  /**
+   * Tick a io cycle : open & close measured windows
+   */
+  void run_a_cycle();
+
+  /**
+   * Write sample.stat.out & print the estimates
+   */
+  void finalize();
+
+  /**
+   * Save or restore the window & estimates
+   */
+  void checkpoint(checkpoint_c* ckpt);
+
+private:
+  sampler_c(); // do not implement
+
+  SAMPLE_PHASE phase(); /**< phase of the current cycle */
+  void start_window();
+  void end_window();
+  bool converged();
+  void link_bits(Counter* m2s_bits, Counter* s2m_bits);
+
+private:
+  int m_period; /**< sampling period in io cycles (0 : disabled) */
+  int m_warmup; /**< detailed warm-up cycles */
+  int m_window; /**< measured cycles */
+  int m_fastfwd; /**< fast-forward cycles */
+  int m_min_windows; /**< windows before the error is checked */
+  float m_target_error; /**< relative half width to stop at (0 : never stop) */
+  double m_z; /**< normal quantile of sample_confidence */
+  float m_freq; /**< io clock frequency in GHz */
+  Counter m_cycle; /**< io cycle */
+  bool m_measuring; /**< a window is open */
+  bool m_done; /**< target error reached */
+
+  sample_window_s m_cur; /**< open window */
+  Counter m_lat_sum[2]; /**< latency sum of reads & writes in the window */
+  Counter m_start_m2s_bits; /**< rc tx bits at the start of the window */
+  Counter m_start_s2m_bits; /**< peer tx bits at the start of the window */
+  std::vector<sample_window_s> m_windows; /**< measured windows */
+  sample_stat_s m_stats[MAX_SAMPLE_METRICS]; /**< estimates */
+
+  cxlsim_c* m_simBase;
+};
+
+} // namespace CXL
+
+#endif // SAMPLER_H
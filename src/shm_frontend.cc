@@ -0,0 +1,232 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : shm_frontend.cc
+ * Description  : Front-end daemon serving a host simulator through shared memory rings
+ *********************************************************************************************/
+
+#include <iostream>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "all_knobs.h"
+#include "cxlsim.h"
+#include "shm_frontend.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+// empty polls before yielding the core, then before sleeping
+#define SHM_SPIN_POLLS 1024
+#define SHM_YIELD_POLLS 65536
+
+void shm_port_s::port_callback(Addr addr, bool write, Counter req_id, void *req) {
+  m_frontend->request_done(m_host, addr, write, req_id, req);
+}
+
+shm_frontend_c::shm_frontend_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  std::string name = *KNOB(KNOB_SHM_NAME);
+  m_name = "/" + name;
+  m_cycle = 0;
+  m_inserted = 0;
+  m_returned = 0;
+
+  uint32_t entries = CFG(KNOB_SHM_RING_ENTRIES);
+  ASSERTM((entries > 0 && (entries & (entries - 1)) == 0), 
+          "shm_ring_entries must be a power of 2\n");
+
+  // a stale object of an earlier run is replaced
+  shm_unlink(m_name.c_str());
+  int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  ASSERTM(fd >= 0, "cannot create the shared memory object\n");
+  m_size = shm_region_size(entries);
+  int ret = ftruncate(fd, m_size);
+  ASSERTM(ret == 0, "cannot size the shared memory object\n");
+  void* addr = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ASSERTM(addr != MAP_FAILED, "cannot map the shared memory object\n");
+  close(fd);
+
+  // the object is zero filled : indices start at 0. magic goes last, the
+  // host waits for it
+  m_region = new (addr) shm_region_s;
+  m_region->m_version = SHM_VERSION;
+  m_region->m_entries = entries;
+  m_region->m_num_hosts = m_simBase->m_num_hosts;
+  m_region->m_sim_cycle.store(0, std::memory_order_relaxed);
+  m_region->m_done.store(0, std::memory_order_relaxed);
+  m_req_ring.init(&m_region->m_req_ctrl, shm_req_entries(m_region), entries);
+  m_done_ring.init(&m_region->m_done_ctrl, shm_done_entries(m_region), entries);
+  m_region->m_magic.store(SHM_MAGIC, std::memory_order_release);
+
+  // the request pointer handed to cxlsim is the host tag
+  m_ports.resize(m_simBase->m_num_hosts);
+  for (int ii = 0; ii < m_simBase->m_num_hosts; ++ii) {
+    m_ports[ii].m_frontend = this;
+    m_ports[ii].m_host = ii;
+    callback_t *trans_callback = 
+      new Callback<shm_port_s, void, Addr, bool, Counter, void*>
+                  (&m_ports[ii], &shm_port_s::port_callback);
+    m_simBase->register_callback(trans_callback, ii);
+  }
+}
+
+shm_frontend_c::~shm_frontend_c() {
+  munmap(m_region, m_size);
+  shm_unlink(m_name.c_str());
+}
+
+void shm_frontend_c::run_sim() {
+  std::cout << "Serving " << m_name << " (" << m_region->m_entries 
+            << " entries per ring)" << std::endl;
+
+  int idle = 0;
+  bool exit = false;
+  while (!exit) {
+    shm_req_s* req = m_req_ring.front();
+    if (req == NULL) {
+      flush_done();
+      wait(&idle);
+      continue;
+    }
+    idle = 0;
+
+    switch (req->m_type) {
+      case SHM_REQ:
+        insert(*req);
+        break;
+      case SHM_ADVANCE:
+        while (m_cycle < req->m_addr) {
+          run_a_cycle();
+        }
+        break;
+      case SHM_EXIT:
+        exit = true;
+        break;
+      default:
+        ASSERTM(0, "unknown shared memory message\n");
+    }
+    m_req_ring.pop();
+  }
+
+  // requests still refused or in flight finish before the stats
+  while (!m_retry_q.empty() || m_returned < m_inserted) {
+    run_a_cycle();
+  }
+  m_simBase->finalize();
+
+  // the host may still be draining the last completions
+  int idle_done = 0;
+  while (!m_done_q.empty()) {
+    flush_done();
+    wait(&idle_done);
+  }
+  m_region->m_done.store(1, std::memory_order_release);
+
+  std::cout << "Served " << m_returned << " requests in " << m_cycle 
+            << " cycles" << std::endl;
+}
+
+void shm_frontend_c::insert(const shm_req_s& req) {
+  // order is kept : nothing passes a refused request
+  if (m_retry_q.empty() && 
+      m_simBase->insert_request(req.m_addr, req.m_write, (void*)(uintptr_t)req.m_tag,
+                                req.m_host % m_simBase->m_num_hosts) != 0) {
+    m_inserted++;
+    return;
+  }
+  m_retry_q.push_back(req);
+}
+
+void shm_frontend_c::run_a_cycle() {
+  while (!m_retry_q.empty()) {
+    const shm_req_s& req = m_retry_q.front();
+    if (m_simBase->insert_request(req.m_addr, req.m_write, (void*)(uintptr_t)req.m_tag,
+                                  req.m_host % m_simBase->m_num_hosts) == 0) {
+      break;
+    }
+    m_inserted++;
+    m_retry_q.pop_front();
+  }
+
+  m_simBase->run_a_cycle(false);
+  m_cycle++;
+  flush_done();
+  m_region->m_sim_cycle.store(m_cycle, std::memory_order_release);
+}
+
+void shm_frontend_c::flush_done() {
+  while (!m_done_q.empty()) {
+    shm_done_s* slot = m_done_ring.alloc();
+    if (slot == NULL) {
+      return;
+    }
+    *slot = m_done_q.front();
+    m_done_ring.push();
+    m_done_q.pop_front();
+  }
+}
+
+void shm_frontend_c::wait(int* idle) {
+  (*idle)++;
+  if (*idle < SHM_SPIN_POLLS) {
+    return;
+  } else if (*idle < SHM_YIELD_POLLS) {
+    std::this_thread::yield();
+  } else {
+    usleep(50);
+  }
+}
+
+void shm_frontend_c::request_done(int host, Addr addr, bool write, Counter req_id, 
+                                  void *req) {
+  shm_done_s done;
+  done.m_addr = addr;
+  done.m_tag = (uint64_t)(uintptr_t)req;
+  done.m_id = req_id;
+  done.m_cycle = m_cycle;
+  done.m_host = host;
+  done.m_write = write;
+  done.m_pad = 0;
+
+  // written straight into the ring unless earlier ones are waiting
+  shm_done_s* slot = m_done_q.empty() ? m_done_ring.alloc() : NULL;
+  if (slot != NULL) {
+    *slot = done;
+    m_done_ring.push();
+  } else {
+    m_done_q.push_back(done);
+  }
+  m_returned++;
+}
+
+} // namespace CXL
@@ -0,0 +1,101 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : shm_frontend.h
+ * Description  : Front-end daemon serving a host simulator through shared memory rings
+ *********************************************************************************************/
+
+#ifndef SHM_FRONTEND_H
+#define SHM_FRONTEND_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "global_types.h"
+#include "global_defs.h"
+#include "shm_ring.h"
+
+namespace cxlsim {
+
+/////////////////////////////////////////////////////////////////////////////
+
+class shm_frontend_c;
+
+// completion port of a host : callbacks carry no host id
+typedef struct shm_port_s {
+  shm_frontend_c* m_frontend;
+  int m_host;
+
+  void port_callback(Addr addr, bool write, Counter req_id, void *req);
+} shm_port_s;
+
+// serves a host simulator in another process (shm_name) : requests & cycle
+// advances come in through the request ring, completions go out through the
+// completion ring (see shm_ring.h)
+class shm_frontend_c {
+public:
+  shm_frontend_c(cxlsim_c* simBase);
+  ~shm_frontend_c();
+
+  void run_sim();
+
+  /**
+   * Called by the port of a host when a request returns
+   */
+  void request_done(int host, Addr addr, bool write, Counter req_id, void *req);
+
+private:
+  shm_frontend_c(); // do not implement
+
+  void insert(const shm_req_s& req); /**< insert or queue behind refused requests */
+  void run_a_cycle();
+  void flush_done(); /**< move completions into the ring while it has room */
+  void wait(int* idle); /**< back off while the host is silent */
+
+public:
+  cxlsim_c* m_simBase;
+
+private:
+  std::string m_name; /**< shared memory object */
+  shm_region_s* m_region; /**< mapped object */
+  size_t m_size; /**< bytes mapped */
+  shm_ring_c<shm_req_s> m_req_ring; /**< host -> daemon */
+  shm_ring_c<shm_done_s> m_done_ring; /**< daemon -> host */
+  std::deque<shm_req_s> m_retry_q; /**< requests refused by a full root complex */
+  std::deque<shm_done_s> m_done_q; /**< completions while the ring is full */
+  std::vector<shm_port_s> m_ports; /**< completion port of each host */
+  Counter m_cycle; /**< io cycle */
+  Counter m_inserted; /**< requests inserted */
+  Counter m_returned; /**< requests returned */
+};
+
+} //namespace CXL
+
+#endif //SHM_FRONTEND_H
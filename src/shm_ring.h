@@ -0,0 +1,191 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : shm_ring.h
+ * Description  : Shared memory layout & SPSC rings of the front-end daemon (shm_name)
+ *********************************************************************************************/
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Self-contained : a host simulator in another process includes this header
+ * only. The daemon creates the object /<shm_name> laid out as
+ *
+ *   shm_region_s | request ring entries | completion ring entries
+ *
+ * and sets m_magic last. The host shm_open()s & mmap()s it, waits for
+ * m_magic, then produces into the request ring & consumes the completion
+ * ring. Entries are written in place, nothing else is copied.
+ *
+ * The request ring carries requests in order, separated by SHM_ADVANCE
+ * messages : the requests before an advance to cycle t are inserted at the
+ * cycle reached so far, then the daemon ticks up to t. The host may run
+ * ahead by any number of advances (pipelining) & waits only for the
+ * completions it needs. SHM_EXIT ends the run & dumps the stats once every
+ * request is back; the host keeps consuming completions until m_done is set.
+ */
+
+namespace cxlsim {
+
+#define SHM_MAGIC 0x4358534d /**< "CXSM" */
+#define SHM_VERSION 1 /**< bumped on layout changes */
+#define SHM_LINE 64 /**< cacheline : producer & consumer indices never share one */
+
+// request ring message types
+typedef enum SHM_MSG_TYPE {
+  SHM_REQ = 0, /**< request */
+  SHM_ADVANCE, /**< tick up to m_addr (io cycle) */
+  SHM_EXIT,    /**< finalize & stop */
+} SHM_MSG_TYPE;
+
+// request ring entry
+typedef struct shm_req_s {
+  uint64_t m_addr; /**< address (SHM_ADVANCE : target cycle) */
+  uint64_t m_tag; /**< host tag, returned with the completion */
+  uint32_t m_type; /**< SHM_MSG_TYPE */
+  uint16_t m_host; /**< host (root complex) id */
+  uint16_t m_write; /**< 0 : read */
+} shm_req_s;
+
+// completion ring entry
+typedef struct shm_done_s {
+  uint64_t m_addr; /**< address */
+  uint64_t m_tag; /**< tag of the request */
+  uint64_t m_id; /**< request id */
+  uint64_t m_cycle; /**< io cycle of the completion */
+  uint16_t m_host; /**< host (root complex) id */
+  uint16_t m_write; /**< 0 : read */
+  uint32_t m_pad;
+} shm_done_s;
+
+// indices of a ring : both only grow, the slot is index & (entries - 1)
+typedef struct shm_ring_ctrl_s {
+  alignas(SHM_LINE) std::atomic<uint64_t> m_head; /**< next entry to consume */
+  alignas(SHM_LINE) std::atomic<uint64_t> m_tail; /**< next entry to produce */
+} shm_ring_ctrl_s;
+
+// head of the shared memory object
+typedef struct shm_region_s {
+  std::atomic<uint32_t> m_magic; /**< SHM_MAGIC once initialized */
+  uint32_t m_version; /**< SHM_VERSION */
+  uint32_t m_entries; /**< entries per ring (power of 2) */
+  uint32_t m_num_hosts; /**< hosts of the simulated system */
+  alignas(SHM_LINE) std::atomic<uint64_t> m_sim_cycle; /**< io cycle reached by the daemon */
+  alignas(SHM_LINE) std::atomic<uint32_t> m_done; /**< daemon finished (after SHM_EXIT) */
+  shm_ring_ctrl_s m_req_ctrl; /**< host -> daemon */
+  shm_ring_ctrl_s m_done_ctrl; /**< daemon -> host */
+} shm_region_s;
+
+// only lock-free atomics are address-free, i.e. work across processes
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "shared memory rings need lock-free atomics");
+
+/**
+ * Bytes of the shared memory object
+ */
+inline size_t shm_region_size(uint32_t entries) {
+  return sizeof(shm_region_s) + entries * (sizeof(shm_req_s) + sizeof(shm_done_s));
+}
+
+inline shm_req_s* shm_req_entries(shm_region_s* region) {
+  return reinterpret_cast<shm_req_s*>(region + 1);
+}
+
+inline shm_done_s* shm_done_entries(shm_region_s* region) {
+  return reinterpret_cast<shm_done_s*>(shm_req_entries(region) + region->m_entries);
+}
+
+// single producer single consumer ring over shared memory. each side keeps a
+// private copy of the index of the other side & reloads it only when the
+// ring looks full (producer) or empty (consumer)
+template <typename T>
+class shm_ring_c {
+public:
+  shm_ring_c() : m_ctrl(NULL), m_entries(NULL), m_mask(0), m_cached(0) {}
+
+  void init(shm_ring_ctrl_s* ctrl, T* entries, uint32_t size) {
+    m_ctrl = ctrl;
+    m_entries = entries;
+    m_mask = size - 1;
+    m_cached = 0;
+  }
+
+  /**
+   * Producer : slot of the next entry (NULL : full), published by push()
+   */
+  T* alloc() {
+    uint64_t tail = m_ctrl->m_tail.load(std::memory_order_relaxed);
+    if (tail - m_cached > m_mask) {
+      m_cached = m_ctrl->m_head.load(std::memory_order_acquire);
+      if (tail - m_cached > m_mask) {
+        return NULL;
+      }
+    }
+    return &m_entries[tail & m_mask];
+  }
+
+  void push() {
+    uint64_t tail = m_ctrl->m_tail.load(std::memory_order_relaxed);
+    m_ctrl->m_tail.store(tail + 1, std::memory_order_release);
+  }
+
+  /**
+   * Consumer : the next entry (NULL : empty), released by pop()
+   */
+  T* front() {
+    uint64_t head = m_ctrl->m_head.load(std::memory_order_relaxed);
+    if (head == m_cached) {
+      m_cached = m_ctrl->m_tail.load(std::memory_order_acquire);
+      if (head == m_cached) {
+        return NULL;
+      }
+    }
+    return &m_entries[head & m_mask];
+  }
+
+  void pop() {
+    uint64_t head = m_ctrl->m_head.load(std::memory_order_relaxed);
+    m_ctrl->m_head.store(head + 1, std::memory_order_release);
+  }
+
+private:
+  shm_ring_ctrl_s* m_ctrl;
+  T* m_entries;
+  uint64_t m_mask;
+  uint64_t m_cached; /**< last seen index of the other side */
+};
+
+} // namespace CXL
+
+#endif // SHM_RING_H
@@ -0,0 +1,134 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : sim_profile.cc
+ * Description  : Simulator self-profiling & progress report
+ *********************************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+
+#include "sim_profile.h"
+#include "cxlsim.h"
+
+#include "all_knobs.h"
+#include "statistics.h"
+
+namespace cxlsim {
+
+sim_profile_c::sim_profile_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  m_period = CFG(KNOB_PROGRESS_PRINT_PERIOD);
+  m_cycle = 0;
+  m_total_reqs = 0;
+  m_done_reqs = 0;
+  m_start = prof_clock_t::now();
+
+  for (int ii = 0; ii < MAX_PROF_STAGES; ++ii) {
+    m_time[ii] = prof_clock_t::duration::zero();
+    m_calls[ii] = 0;
+  }
+}
+
+sim_profile_c::~sim_profile_c() {
+}
+
+void sim_profile_c::set_total_reqs(Counter total) {
+  m_total_reqs = total;
+}
+
+void sim_profile_c::req_done() {
+  m_done_reqs++;
+}
+
+void sim_profile_c::run_a_cycle() {
+  m_cycle++;
+  if (m_period > 0 && m_cycle % m_period == 0) {
+    print_progress();
+  }
+}
+
+void sim_profile_c::finalize() {
+  if (m_period > 0) {
+    print_progress();
+  }
+
+#ifdef CXL_PROFILE
+  std::ofstream* out = m_simBase->get_output_stream("profile.out");
+  if (out == NULL) {
+    return;
+  }
+
+  double wall = elapsed();
+  double total = std::chrono::duration<double>(m_time[PROF_RUN_A_CYCLE]).count();
+  *out << std::fixed << std::setprecision(3)
+       << "io cycles           : " << m_cycle << "\n"
+       << "wall time (s)       : " << wall << "\n"
+       << "io cycles / wall s  : " << (wall > 0 ? m_cycle / wall : 0.0) << "\n\n";
+
+  *out << std::left << std::setw(16) << "stage"
+       << std::right << std::setw(14) << "calls"
+       << std::setw(14) << "time (ms)"
+       << std::setw(12) << "ns / call"
+       << std::setw(10) << "% cycle" << "\n";
+  for (int ii = 0; ii < MAX_PROF_STAGES; ++ii) {
+    double sec = std::chrono::duration<double>(m_time[ii]).count();
+    *out << std::left << std::setw(16) << prof_stage_string[ii]
+         << std::right << std::setw(14) << m_calls[ii]
+         << std::setw(14) << sec * 1e3
+         << std::setw(12) << (m_calls[ii] ? sec * 1e9 / m_calls[ii] : 0.0)
+         << std::setw(10) << (total > 0 ? 100.0 * sec / total : 0.0) << "\n";
+  }
+  out->flush();
+#endif
+}
+
+double sim_profile_c::elapsed() {
+  return std::chrono::duration<double>(prof_clock_t::now() - m_start).count();
+}
+
+// cycle, requests done, simulation speed & eta from the fraction of requests done
+void sim_profile_c::print_progress() {
+  double wall = elapsed();
+  std::cout << std::fixed << std::setprecision(1)
+            << "[cxlsim] cycle " << m_cycle
+            << " reqs " << m_done_reqs;
+  if (m_total_reqs > 0) {
+    std::cout << "/" << m_total_reqs;
+  }
+  std::cout << " " << wall << "s "
+            << (wall > 0 ? m_cycle / wall / 1e3 : 0.0) << " Kcycles/s";
+  if (m_total_reqs > 0 && m_done_reqs > 0 && m_done_reqs < m_total_reqs) {
+    double eta = wall * (m_total_reqs - m_done_reqs) / m_done_reqs;
+    std::cout << " eta " << eta << "s";
+  }
+  std::cout << std::endl;
+}
+
+} // namespace CXL
@@ -0,0 +1,160 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : sim_profile.h
+ * Description  : Simulator self-profiling & progress report
+ *********************************************************************************************/
+
+#ifndef SIM_PROFILE_H
+#define SIM_PROFILE_H
+
+#include <chrono>
+#include <string>
+
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+// profiled code regions
+// - nested regions are also counted in the enclosing region
+//   (generate_flits in txtrans, everything in run_a_cycle)
+typedef enum PROF_STAGE {
+  PROF_RUN_A_CYCLE = 0, /**< cxlsim_c::run_a_cycle */
+  PROF_TXTRANS,         /**< pcie_ep_c::process_txtrans */
+  PROF_GEN_FLITS,       /**< vc_buff_c::generate_flits */
+  PROF_TXDLL,           /**< pcie_ep_c::process_txdll */
+  PROF_TXPHYS,          /**< pcie_ep_c::process_txphys */
+  PROF_RXPHYS,          /**< pcie_ep_c::process_rxphys */
+  PROF_RXDLL,           /**< pcie_ep_c::process_rxdll */
+  PROF_RXTRANS,         /**< pcie_ep_c::process_rxtrans */
+  PROF_RAMULATOR,       /**< ramulator tick */
+  MAX_PROF_STAGES
+} PROF_STAGE;
+
+static const std::string prof_stage_string[MAX_PROF_STAGES] = {
+  "run_a_cycle",
+  "txtrans",
+  "generate_flits",
+  "txdll",
+  "txphys",
+  "rxphys",
+  "rxdll",
+  "rxtrans",
+  "ramulator"
+};
+
+// scoped timers are compiled in only with CXL_PROFILE
+#ifdef CXL_PROFILE
+#define PROFILE_SCOPE(prof, stage) prof_scope_c prof_scope(prof, stage)
+#else
+#define PROFILE_SCOPE(prof, stage)
+#endif
+
+// collects wall time per stage & prints progress with an eta
+class sim_profile_c {
+public:
+  typedef std::chrono::steady_clock prof_clock_t;
+
+  /**
+   * Constructor
+   */
+  sim_profile_c(cxlsim_c* simBase);
+
+  /**
+   * Destructor
+   */
+  ~sim_profile_c();
+
+  /**
+   * Add wall time of a stage
+   */
+  void add(PROF_STAGE stage, prof_clock_t::duration time) {
+    m_time[stage] += time;
+    m_calls[stage]++;
+  }
+
+  /**
+   * Number of requests the outer simulator will insert (0 : unknown, no eta)
+   */
+  void set_total_reqs(Counter total);
+
+  /**
+   * Count a finished request
+   */
+  void req_done();
+
+  /**
+   * Tick a io cycle : print a progress line every progress_print_period
+   */
+  void run_a_cycle();
+
+  /**
+   * Write profile.out & the final progress line
+   */
+  void finalize();
+
+private:
+  sim_profile_c(); // do not implement
+
+  double elapsed(); /**< wall seconds since the constructor */
+  void print_progress();
+
+private:
+  int m_period; /**< io cycles between progress lines (0 : disabled) */
+  Counter m_cycle; /**< io cycle */
+  Counter m_total_reqs; /**< requests expected */
+  Counter m_done_reqs; /**< requests finished */
+  prof_clock_t::time_point m_start; /**< wall time at start */
+  prof_clock_t::duration m_time[MAX_PROF_STAGES]; /**< wall time per stage */
+  Counter m_calls[MAX_PROF_STAGES]; /**< calls per stage */
+
+  cxlsim_c* m_simBase;
+};
+
+// adds the wall time of the enclosing scope to a stage
+class prof_scope_c {
+public:
+  prof_scope_c(sim_profile_c* prof, PROF_STAGE stage)
+    : m_prof(prof), m_stage(stage), m_start(sim_profile_c::prof_clock_t::now()) {
+  }
+
+  ~prof_scope_c() {
+    m_prof->add(m_stage, sim_profile_c::prof_clock_t::now() - m_start);
+  }
+
+private:
+  sim_profile_c* m_prof;
+  PROF_STAGE m_stage;
+  sim_profile_c::prof_clock_t::time_point m_start;
+};
+
+} // namespace CXL
+
+#endif // SIM_PROFILE_H
@@ -48,47 +48,6 @@ namespace cxlsim {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-// get the output stream
-std::ofstream* getOutputStream(const std::string& filename, cxlsim_c* m_simBase) {
-  std::string fullpath = *m_simBase->m_knobs->KNOB_STATISTICS_OUT_DIRECTORY;
-  fullpath = fullpath + "/" + filename;
-
-  // stat name already encountered
-  // check if the output stream is opened then do nothing
-  // otherwise open the stream
-  std::map<std::string, std::ofstream*>::iterator iter =
-    m_simBase->m_AllStatsOutputStreams.find(filename);
-
-  std::ofstream* stream = NULL;
-
-  // first time this filename is encounterd
-  // create the std::ofstream object
-  if (iter == m_simBase->m_AllStatsOutputStreams.end()) {
-    stream = new std::ofstream();
-    stream->exceptions(std::ofstream::eofbit | std::ofstream::failbit | std::ofstream::badbit);
-
-    try {
-      stream->open(fullpath.c_str(), std::ios_base::out);
-
-      if (stream->is_open())
-        m_simBase->m_AllStatsOutputStreams[filename] = stream;
-      else {
-        delete stream;
-        stream = NULL;
-      }
-    } catch (std::ofstream::failure exp) {
-      std::string strException = exp.what();
-      std::cout << strException;
-      delete stream;
-      stream = NULL;
-    }
-  } else {
-    stream = m_simBase->m_AllStatsOutputStreams[filename];
-  }
-
-  return stream;
-}
-
 // get global stats
 AbstractStat& getGlobalStat(long statID, ProcessorStatistics* m_ProcStat) {
   AbstractStat& pStat = (*m_ProcStat)[statID];
@@ -117,11 +76,6 @@ unsigned int getCycleCount() {
   return 20000;
 }
 
-// initialize core stats
-void init_per_core_stats(unsigned num_cores, cxlsim_c* simBase) {
-  simBase->m_ProcessorStats->setNumCores(num_cores);
-}
-
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 // dump out all stats to the file
@@ -209,6 +163,8 @@ void GlobalStatistics::saveStats() {
 
 // dump out all stats to the file
 void GlobalStatistics::saveStats(std::string ext) {
+  syncCounters();
+
   std::vector<AbstractStat*>::iterator iter = m_globalStats.begin();
   std::vector<AbstractStat*>::iterator end = m_globalStats.end();
 
@@ -229,7 +185,7 @@ void GlobalStatistics::saveStats(std::string ext) {
         oldFileName = filename;
       }
 
-      std::ofstream* pStream = getOutputStream(filename, m_simBase);
+      std::ofstream* pStream = m_simBase->get_output_stream(filename);
       if (NULL != pStream) {
         std::ofstream& stream = (*pStream);
 
@@ -277,7 +233,7 @@ void GlobalStatistics::saveStats(std::string ext) {
 
     const std::string& filename = pDistribution->getOutputFilename() + ext;
 
-    std::ofstream* pStream = getOutputStream(filename, m_simBase);
+    std::ofstream* pStream = m_simBase->get_output_stream(filename);
     if (NULL != pStream) {
       std::ofstream& stream = (*pStream);
       pDistribution->writeTo(stream);
@@ -289,6 +245,8 @@ void GlobalStatistics::saveStats(std::string ext) {
 
 // dump out all stats to the file
 void GlobalStatistics::writeTo(std::ofstream& stream) {
+  syncCounters();
+
   std::vector<AbstractStat*>::iterator iter = m_globalStats.begin();
   std::vector<AbstractStat*>::iterator end = m_globalStats.end();
 
@@ -325,7 +283,7 @@ void CoreStatistics::saveStats(std::string ext) {
     AbstractStat* pStat = (*iter);
     const std::string& filename = pStat->getOutputFilename() + ext;
 
-    std::ofstream& stream = (*getOutputStream(filename, m_simBase));
+    std::ofstream& stream = (*m_simBase->get_output_stream(filename));
 
     // ignore distribution members, they will be printed by
     // the distributions they belong to
@@ -345,7 +303,7 @@ void CoreStatistics::saveStats(std::string ext) {
 
     const std::string& filename = pDistribution->getOutputFilename() + ext;
 
-    std::ofstream* pStream = getOutputStream(filename, m_simBase);
+    std::ofstream* pStream = m_simBase->get_output_stream(filename);
     if (NULL != pStream) {
       std::ofstream& stream = (*pStream);
       pDistribution->writeTo(stream);
@@ -376,6 +334,7 @@ ProcessorStatistics::~ProcessorStatistics() {
   }
 
   m_allCoresStats.clear();
+  delete m_globalStatistics;
 }
 
 // return global stats
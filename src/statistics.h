@@ -61,6 +61,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
 
 #include "statsEnums.h"
 #include "global_defs.h"
@@ -79,10 +80,6 @@ namespace cxlsim {
 unsigned int getInstructionCount();
 unsigned int getPseudoRetiredInstructionCount();
 unsigned int getCycleCount();
-void init_per_core_stats(unsigned num_cores, cxlsim_c* simBase);
-
-std::ofstream* getOutputStream(const std::string& filename);
-
 class AbstractStat;
 
 AbstractStat& getGlobalStat(long ID, ProcessorStatistics* m_ProcStat);
@@ -103,6 +100,7 @@ public:
   AbstractStat(const std::string& str, const std::string& outputfilename, long ID,
                bool corewide = false, bool isTemplate = true)
     : m_pRatioStat(NULL),
+      m_pCounter(NULL),
       m_count(0),
       m_total_count(0),
       m_ID(ID),
@@ -145,6 +143,22 @@ public:
     m_suffix = suffix;
   }
 
+  /**
+   * Bind the stat to its slot of the flat counter array (see STAT_EVENT).
+   */
+  inline void bindCounter(uint64_t* pCounter) {
+    m_pCounter = pCounter;
+  }
+
+  /**
+   * Pull the value from the flat counter array. Called before dumping.
+   */
+  inline void syncCounter() {
+    if (m_pCounter != NULL) {
+      m_count = *m_pCounter;
+    }
+  }
+
   /**
    * Get output file name.
    */
@@ -159,6 +173,13 @@ public:
     return m_name;
   }
 
+  /**
+   * Get the stat id (index of the flat counter array).
+   */
+  long getID() {
+    return m_ID;
+  }
+
   /**
    * Increment the counter.
    */
@@ -218,6 +239,7 @@ public:
 
 protected:
   AbstractStat* m_pRatioStat; /**< stat that to use in the ratio */
+  uint64_t* m_pCounter; /**< slot in the flat counter array */
   unsigned long long m_count; /**< count during the current stat interval */
   unsigned long long m_total_count; /**< total count from beginning of run */
   long m_ID; /**< stat id */
@@ -846,6 +868,15 @@ public:
     }
   }
 
+  /**
+   * Pull all stat values from the flat counter array.
+   */
+  void syncCounters() {
+    for (auto pStat : m_globalStats) {
+      pStat->syncCounter();
+    }
+  }
+
   /**
    * Dump out all stats to the file.
    */
@@ -1077,14 +1108,18 @@ private:
   m_simBase->m_ProcessorStats->core(            \
     coreID)[Event - PER_CORE_STATS_ENUM_FIRST] += delta;
 
+// global stats are counted in a flat array (all_stats_c::m_counters) and
+// pulled into the stat objects only when they are dumped. do not update
+// global stats through ProcessorStatistics::operator[]
+
 // increment a stat
-#define STAT_EVENT(ID) (*m_simBase->m_ProcessorStats)[ID]++
+#define STAT_EVENT(ID) m_simBase->m_stat_counters[ID]++
 
 // decrement a stat
-#define STAT_EVENT_M(ID) (*m_simBase->m_ProcessorStats)[ID]--
+#define STAT_EVENT_M(ID) m_simBase->m_stat_counters[ID]--
 
 // increat a stat with delta value
-#define STAT_EVENT_N(ID, delta) (*m_simBase->m_ProcessorStats)[ID] += delta
+#define STAT_EVENT_N(ID, delta) m_simBase->m_stat_counters[ID] += delta
 
 // POWER EVENT
 #define POWER_CORE_EVENT(coreID, Event) STAT_CORE_EVENT(coreID, Event)
@@ -0,0 +1,259 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : trace_event.cc
+ * Description  : Chrome trace-event (json) export of packet lifecycles
+ *********************************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "trace_event.h"
+#include "packet_info.h"
+#include "checkpoint.h"
+#include "cxlsim.h"
+#include "pcie_rc.h"
+#include "cxl_t3.h"
+#include "cxl_switch.h"
+
+#include "all_knobs.h"
+#include "statistics.h"
+
+namespace cxlsim {
+
+trace_event_c::trace_event_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  m_enable = CFG(KNOB_TRACE_EVENT);
+  m_sample = std::max(CFG(KNOB_TRACE_SAMPLE), 1);
+  m_counter_period = CFG(KNOB_TRACE_COUNTER_PERIOD);
+  m_freq = CFG(KNOB_CLOCK_IO);
+  m_cycle = 0;
+  m_req_cnt = 0;
+  m_event_cnt = 0;
+  m_stream = NULL;
+  m_num_pids = 0;
+  m_mxp_pid = 0;
+  m_switch_pid = -1;
+  m_req_pid = 0;
+
+  if (!enabled()) {
+    return;
+  }
+
+  // the stat directory is otherwise created only at the final stat dump
+  std::string stat_path = *KNOB(KNOB_STATISTICS_OUT_DIRECTORY);
+  mkdir(stat_path.c_str(), S_IRWXU);
+
+  m_stream = m_simBase->get_output_stream("trace.json");
+  if (m_stream == NULL) {
+    m_enable = false;
+    return;
+  }
+
+  *m_stream << std::fixed << std::setprecision(6)
+            << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  // process & thread names
+  // - the tx phys of each port is a thread of the component owning it
+  for (int ii = 0; ii < (int)m_simBase->m_rcs.size(); ++ii) {
+    int pid = m_num_pids;
+    name_process("root complex " + std::to_string(ii));
+    name_thread(m_simBase->m_rcs[ii], pid, 0, "tx phys");
+  }
+
+  m_mxp_pid = m_num_pids;
+  cxl_switch_c* sw = m_simBase->m_switch;
+  for (int ii = 0; ii < (int)m_simBase->m_mxps.size(); ++ii) {
+    cxlt3_c* mxp = m_simBase->m_mxps[ii];
+    int pid = m_num_pids;
+    name_process("mxp " + std::to_string(ii));
+    int num_ports = sw ? 1 : mxp->num_ld();
+    for (int ld = 0; ld < num_ports; ++ld) {
+      name_thread(mxp->get_port(ld), pid, ld, "tx phys ld " + std::to_string(ld));
+    }
+  }
+
+  if (sw) {
+    m_switch_pid = m_num_pids;
+    name_process("switch");
+    for (int ii = 0; ii < (int)m_simBase->m_rcs.size(); ++ii) {
+      name_thread(sw->get_usp(ii), m_switch_pid, ii, 
+                  "tx phys usp " + std::to_string(ii));
+    }
+    for (int ii = 0; ii < (int)m_simBase->m_mxps.size(); ++ii) {
+      name_thread(sw->get_dsp(ii), m_switch_pid, m_simBase->m_num_hosts + ii, 
+                  "tx phys dsp " + std::to_string(ii));
+    }
+  }
+
+  m_req_pid = m_num_pids;
+  name_process("requests");
+}
+
+trace_event_c::~trace_event_c() {
+}
+
+bool trace_event_c::enabled() {
+  return m_enable;
+}
+
+void trace_event_c::start_req(cxl_req_s* req) {
+  if (!enabled()) {
+    return;
+  }
+
+  req->m_traced = (m_req_cnt++ % m_sample == 0);
+  if (req->m_traced) {
+    write_async(req, req->m_write ? "WR" : "RD", 'b', req->m_issue_cycle);
+  }
+}
+
+void trace_event_c::end_req(cxl_req_s* req) {
+  write_async(req, req->m_write ? "WR" : "RD", 'e', m_simBase->m_cycle);
+}
+
+bool trace_event_c::sample_flit(flit_s* flit) {
+  return enabled() && (flit->m_id % m_sample == 0);
+}
+
+void trace_event_c::req_span(cxl_req_s* req, const std::string& name,
+                             Counter start, Counter end) {
+  write_async(req, name, 'b', start);
+  write_async(req, name, 'e', std::max(start, end));
+}
+
+void trace_event_c::flit_span(flit_s* flit, pcie_ep_c* ep, Counter start,
+                              Counter end) {
+  begin_event();
+  *m_stream << "{\"name\":\"flit " << flit->m_id
+            << "\",\"cat\":\"flit\",\"ph\":\"X\",\"pid\":" << ep->m_trace_pid
+            << ",\"tid\":" << ep->m_trace_tid << ",\"ts\":" << timestamp(start)
+            << ",\"dur\":" << timestamp(end) - timestamp(start)
+            << ",\"args\":{\"bits\":" << flit->m_bits
+            << ",\"slots\":" << flit->num_slots() << "}}";
+}
+
+void trace_event_c::run_a_cycle() {
+  if (m_counter_period > 0 && m_cycle % m_counter_period == 0) {
+    for (auto rc : m_simBase->m_rcs) {
+      write_counter(rc->m_trace_pid, "pending q", rc->pending_size());
+      write_counter(rc->m_trace_pid, "replay buffer", rc->replay_size());
+    }
+
+    cxl_switch_c* sw = m_simBase->m_switch;
+    for (int ii = 0; ii < (int)m_simBase->m_mxps.size(); ++ii) {
+      cxlt3_c* mxp = m_simBase->m_mxps[ii];
+      int replay = 0;
+      int num_ports = sw ? 1 : mxp->num_ld();
+      for (int ld = 0; ld < num_ports; ++ld) {
+        replay += mxp->get_port(ld)->replay_size();
+      }
+      write_counter(m_mxp_pid + ii, "pending q", mxp->pending_size());
+      write_counter(m_mxp_pid + ii, "dram pending", mxp->dram_pending_size());
+      write_counter(m_mxp_pid + ii, "replay buffer", replay);
+    }
+
+    if (sw) {
+      write_counter(m_switch_pid, "pending q", sw->pending_size());
+      for (int ii = 0; ii < (int)m_simBase->m_rcs.size(); ++ii) {
+        write_counter(m_switch_pid, "replay buffer usp " + std::to_string(ii),
+                      sw->get_usp(ii)->replay_size());
+      }
+      for (int ii = 0; ii < (int)m_simBase->m_mxps.size(); ++ii) {
+        write_counter(m_switch_pid, "replay buffer dsp " + std::to_string(ii),
+                      sw->get_dsp(ii)->replay_size());
+      }
+    }
+  }
+  m_cycle++;
+}
+
+void trace_event_c::finalize() {
+  if (!enabled()) {
+    return;
+  }
+
+  *m_stream << "\n]}" << std::endl;
+  m_enable = false;
+}
+
+void trace_event_c::checkpoint(checkpoint_c* ckpt) {
+  ckpt->io(m_cycle);
+  ckpt->io(m_req_cnt);
+}
+
+void trace_event_c::begin_event() {
+  *m_stream << (m_event_cnt++ ? ",\n" : "\n");
+}
+
+void trace_event_c::name_process(const std::string& name) {
+  int pid = m_num_pids++;
+  begin_event();
+  *m_stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"args\":{\"name\":\"" << name << "\"}}";
+  begin_event();
+  *m_stream << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"args\":{\"sort_index\":" << pid << "}}";
+}
+
+void trace_event_c::name_thread(pcie_ep_c* ep, int pid, int tid, 
+                                const std::string& name) {
+  ep->m_trace_pid = pid;
+  ep->m_trace_tid = tid;
+  begin_event();
+  *m_stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":" << tid << ",\"args\":{\"name\":\"" << name << "\"}}";
+}
+
+double trace_event_c::timestamp(Counter cycle) {
+  return cycle / (m_freq * 1000.0);
+}
+
+void trace_event_c::write_async(cxl_req_s* req, const std::string& name,
+                                char phase, Counter cycle) {
+  begin_event();
+  *m_stream << "{\"name\":\"" << name << "\",\"cat\":\"req\",\"ph\":\"" << phase
+            << "\",\"id\":" << req->m_id << ",\"pid\":" << m_req_pid
+            << ",\"tid\":0,\"ts\":" << timestamp(cycle);
+  if (phase == 'b') {
+    *m_stream << ",\"args\":{\"addr\":" << req->m_addr << "}";
+  }
+  *m_stream << "}";
+}
+
+void trace_event_c::write_counter(int pid, const std::string& name, int value) {
+  begin_event();
+  *m_stream << "{\"name\":\"" << name << "\",\"ph\":\"C\",\"pid\":" << pid
+            << ",\"ts\":" << timestamp(m_cycle)
+            << ",\"args\":{\"value\":" << value << "}}";
+}
+
+} // namespace CXL
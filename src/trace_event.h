@@ -0,0 +1,143 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**********************************************************************************************
+ * File         : trace_event.h
+ * Description  : Chrome trace-event (json) export of packet lifecycles
+ *********************************************************************************************/
+
+#ifndef TRACE_EVENT_H
+#define TRACE_EVENT_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "global_defs.h"
+#include "global_types.h"
+
+namespace cxlsim {
+
+// writes a chrome json trace (chrome://tracing, ui.perfetto.dev)
+// - one process per root complex, per mxp & for the switch, and one
+//   holding the request lifecycles
+// - every trace_sample-th request is followed through all pipeline stages
+//   as nested async slices
+// - every trace_sample-th flit is drawn on the physical link of its sender
+//   (one thread per port)
+// - queue depths are written as counter tracks
+// - timestamps are io cycles converted to time with the io clock
+class trace_event_c {
+public:
+  /**
+   * Constructor
+   */
+  trace_event_c(cxlsim_c* simBase);
+
+  /**
+   * Destructor
+   */
+  ~trace_event_c();
+
+  /**
+   * Returns true if trace events are enabled
+   */
+  bool enabled();
+
+  /**
+   * Sample a new request & open its lifecycle if it is traced
+   */
+  void start_req(cxl_req_s* req);
+
+  /**
+   * Close the lifecycle of a traced request
+   */
+  void end_req(cxl_req_s* req);
+
+  /**
+   * Decide whether a flit is traced
+   */
+  bool sample_flit(flit_s* flit);
+
+  /**
+   * Stage of a traced request, [start, end) in io cycles
+   */
+  void req_span(cxl_req_s* req, const std::string& name, Counter start,
+                Counter end);
+
+  /**
+   * Physical layer transmission of a traced flit
+   */
+  void flit_span(flit_s* flit, pcie_ep_c* ep, Counter start, Counter end);
+
+  /**
+   * Tick a io cycle : write queue depth counters
+   */
+  void run_a_cycle();
+
+  /**
+   * Close the trace
+   */
+  void finalize();
+
+  /**
+   * Save or restore the sampling position
+   */
+  void checkpoint(checkpoint_c* ckpt);
+
+private:
+  trace_event_c(); // do not implement
+
+  void begin_event(); /**< separator between events */
+  void name_process(const std::string& name); /**< next process id */
+  void name_thread(pcie_ep_c* ep, int pid, int tid, const std::string& name);
+  void write_async(cxl_req_s* req, const std::string& name, char phase,
+                   Counter cycle);
+  double timestamp(Counter cycle); /**< io cycle to microseconds */
+  void write_counter(int pid, const std::string& name, int value);
+
+private:
+  bool m_enable; /**< trace enabled */
+  int m_sample; /**< trace one out of every m_sample requests & flits */
+  int m_counter_period; /**< io cycles between counters (0 : no counters) */
+  float m_freq; /**< io clock frequency in GHz */
+  Counter m_cycle; /**< io cycle */
+  Counter m_req_cnt; /**< requests seen by start_req */
+  Counter m_event_cnt; /**< events written */
+  std::ofstream* m_stream; /**< json output */
+  int m_num_pids; /**< processes named so far */
+  int m_mxp_pid; /**< process of the first mxp */
+  int m_switch_pid; /**< process of the switch (-1 : none) */
+  int m_req_pid; /**< process of the request lifecycles */
+
+  cxlsim_c* m_simBase;
+};
+
+} // namespace CXL
+
+#endif // TRACE_EVENT_H
@@ -0,0 +1,366 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : traffic_gen.cc
+ * Description  : Synthetic traffic generator (in place of the trace driven core)
+ *********************************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include "all_knobs.h"
+#include "cxlsim.h"
+#include "traffic_gen.h"
+#include "assert_macros.h"
+
+namespace cxlsim {
+
+//////////////////////////////////////////////////////////////////////////////
+
+void traffic_rng_s::seed(uint64_t seed) {
+  // splitmix64 : spreads small seeds & never yields a zero state
+  uint64_t z = seed + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  m_state = (z ^ (z >> 31)) | 1;
+}
+
+uint64_t traffic_rng_s::next() {
+  m_state ^= m_state >> 12;
+  m_state ^= m_state << 25;
+  m_state ^= m_state >> 27;
+  return m_state * 0x2545f4914f6cdd1dULL;
+}
+
+double traffic_rng_s::uniform() {
+  return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// log1p(x) / x & expm1(x) / x, stable around 0
+static double helper1(double x) {
+  return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+static double helper2(double x) {
+  return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+}
+
+zipf_dist_c::zipf_dist_c(uint64_t n, double alpha) {
+  ASSERTM(n > 0 && alpha > 0.0, "zipf needs elements & a positive exponent\n");
+  m_n = n;
+  m_alpha = alpha;
+  m_h_integral_x1 = h_integral(1.5) - 1.0;
+  m_h_integral_n = h_integral(n + 0.5);
+  m_s = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
+}
+
+uint64_t zipf_dist_c::sample(traffic_rng_s* rng) {
+  while (true) {
+    double u = m_h_integral_n + rng->uniform() * (m_h_integral_x1 - m_h_integral_n);
+    double x = h_integral_inverse(u);
+    uint64_t k = static_cast<uint64_t>(x + 0.5);
+    if (k < 1) {
+      k = 1;
+    } else if (k > m_n) {
+      k = m_n;
+    }
+
+    if (k - x <= m_s || u >= h_integral(k + 0.5) - h(k)) {
+      return k;
+    }
+  }
+}
+
+double zipf_dist_c::h(double x) {
+  return std::exp(-m_alpha * std::log(x));
+}
+
+double zipf_dist_c::h_integral(double x) {
+  double log_x = std::log(x);
+  return helper2((1.0 - m_alpha) * log_x) * log_x;
+}
+
+double zipf_dist_c::h_integral_inverse(double x) {
+  double t = x * (1.0 - m_alpha);
+  if (t < -1.0) {
+    t = -1.0;
+  }
+  return std::exp(helper1(t) * x);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+traffic_gen_c::traffic_gen_c(cxlsim_c* simBase) {
+  m_simBase = simBase;
+  m_cycle = 0;
+  m_zipf = NULL;
+  m_zipf_mul = 1;
+  m_zipf_add = 0;
+
+  std::string pattern = *KNOB(KNOB_TRAFFIC_PATTERN);
+  m_pattern = MAX_TRAFFIC_PATTERNS;
+  for (int ii = 0; ii < MAX_TRAFFIC_PATTERNS; ++ii) {
+    if (pattern == traffic_pattern_string[ii]) {
+      m_pattern = static_cast<TRAFFIC_PATTERN>(ii);
+    }
+  }
+  ASSERTM(m_pattern != MAX_TRAFFIC_PATTERNS, "unknown traffic_pattern\n");
+
+  std::string issue = *KNOB(KNOB_TRAFFIC_ISSUE);
+  m_issue = MAX_TRAFFIC_ISSUES;
+  for (int ii = 0; ii < MAX_TRAFFIC_ISSUES; ++ii) {
+    if (issue == traffic_issue_string[ii]) {
+      m_issue = static_cast<TRAFFIC_ISSUE>(ii);
+    }
+  }
+  ASSERTM(m_issue != MAX_TRAFFIC_ISSUES, "unknown traffic_issue\n");
+
+  m_num_reqs = CFG(KNOB_TRAFFIC_NUM_REQS);
+  m_read_ratio = CFG(KNOB_TRAFFIC_READ_RATIO);
+  m_base = CFG(KNOB_TRAFFIC_BASE_ADDR);
+  m_lines = CFG(KNOB_TRAFFIC_FOOTPRINT) / CFG(KNOB_RAMULATOR_CACHELINE_SIZE);
+  m_stride = CFG(KNOB_TRAFFIC_STRIDE);
+  m_rate = CFG(KNOB_TRAFFIC_RATE);
+  m_outstanding = CFG(KNOB_TRAFFIC_OUTSTANDING);
+  ASSERTM(m_lines > 0, "traffic_footprint is smaller than a cacheline\n");
+  ASSERTM((m_issue == TRAFFIC_CLOSED || m_rate > 0.0), "traffic_rate must be positive\n");
+  ASSERTM((m_issue != TRAFFIC_CLOSED || m_outstanding > 0), 
+          "traffic_outstanding must be positive\n");
+
+  if (m_pattern == TRAFFIC_ZIPF) {
+    m_zipf = new zipf_dist_c(m_lines, CFG(KNOB_TRAFFIC_ZIPF_ALPHA));
+
+    // rank -> line is the affine map (mul * rank + add) mod lines, a
+    // permutation as long as mul is coprime to lines. a multiplier near
+    // lines / golden ratio puts consecutive ranks far apart
+    m_zipf_mul = std::max<Addr>(static_cast<Addr>(m_lines * 0.6180339887), 1);
+    auto gcd = [](Addr a, Addr b) {
+      while (b != 0) {
+        Addr t = a % b;
+        a = b;
+        b = t;
+      }
+      return a;
+    };
+    while (gcd(m_zipf_mul, m_lines) != 1) {
+      m_zipf_mul++;
+    }
+    m_zipf_add = 0x9e3779b97f4a7c15ULL % m_lines;
+  }
+
+  // every host has its own streams, derived from the seed
+  uint64_t seed = CFG(KNOB_TRAFFIC_SEED);
+  m_hosts.resize(m_simBase->m_num_hosts);
+  for (int ii = 0; ii < m_simBase->m_num_hosts; ++ii) {
+    traffic_host_s& host = m_hosts[ii];
+    host.m_host = ii;
+    host.m_rng.seed(seed * 0x100000001b3ULL + 2 * ii);
+    host.m_arrival_rng.seed(seed * 0x100000001b3ULL + 2 * ii + 1);
+    host.m_cursor = 0;
+    host.m_credit = 0.0;
+    host.m_next_arrival = 0.0;
+    host.m_due = 0;
+    host.m_has_next = false;
+    host.m_next_addr = 0;
+    host.m_next_write = false;
+    host.m_issued = 0;
+    host.m_inserted = 0;
+    host.m_returned = 0;
+
+    // the request pointer handed to cxlsim is the host state
+    callback_t *trans_callback = 
+      new Callback<traffic_gen_c, void, Addr, bool, Counter, void*>
+                  (&(*this), &traffic_gen_c::traffic_callback);
+    m_simBase->register_callback(trans_callback, ii);
+  }
+}
+
+traffic_gen_c::~traffic_gen_c() {
+  delete m_zipf;
+}
+
+void traffic_gen_c::run_a_cycle(bool pll_locked) {
+  for (auto& host : m_hosts) {
+    arrive(&host);
+    issue(&host);
+  }
+
+  m_simBase->run_a_cycle(pll_locked);
+  m_cycle++;
+}
+
+void traffic_gen_c::run_sim() {
+  Counter total = m_num_reqs * m_hosts.size();
+  if (m_pattern == TRAFFIC_GUPS) {
+    total *= 2;
+  }
+  m_simBase->set_total_reqs(total);
+
+  while (!finished() && !m_simBase->sampling_done()) {
+    run_a_cycle(false);
+  }
+
+  Counter returned = 0;
+  for (auto& host : m_hosts) {
+    returned += host.m_returned;
+  }
+  std::cout << "Traffic " << traffic_pattern_string[m_pattern] << " / " 
+            << traffic_issue_string[m_issue] << " : " << returned 
+            << " requests in " << m_cycle << " cycles" << std::endl;
+  std::cout << "Simulation ended" << std::endl;
+}
+
+void traffic_gen_c::arrive(traffic_host_s* host) {
+  Counter left = m_num_reqs - host->m_issued - host->m_due;
+  if (left == 0) {
+    return;
+  }
+
+  Counter arrivals = 0;
+  switch (m_issue) {
+    case TRAFFIC_FIXED:
+      host->m_credit += m_rate;
+      arrivals = static_cast<Counter>(host->m_credit);
+      host->m_credit -= arrivals;
+      break;
+    case TRAFFIC_POISSON:
+      while (host->m_next_arrival <= m_cycle) {
+        double u = host->m_arrival_rng.uniform();
+        host->m_next_arrival += -std::log(1.0 - u) / m_rate;
+        arrivals++;
+      }
+      break;
+    case TRAFFIC_CLOSED: {
+      // gups writes waiting for insertion hold their slot
+      Counter busy = host->m_inserted - host->m_returned + 
+                     host->m_updates.size() + host->m_due;
+      if (busy < (Counter)m_outstanding) {
+        arrivals = m_outstanding - busy;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  host->m_due += std::min(arrivals, left);
+}
+
+void traffic_gen_c::issue(traffic_host_s* host) {
+  void* req = static_cast<void*>(host);
+
+  // gups : updates of returned reads go first
+  while (!host->m_updates.empty()) {
+    Addr addr = host->m_updates.front();
+    if (m_simBase->insert_request(addr, true, req, host->m_host) == 0) {
+      return;
+    }
+    host->m_updates.pop_front();
+    host->m_inserted++;
+  }
+
+  // open loop requests wait here while the root complex is full, the
+  // address stream does not depend on when they get in
+  while (host->m_due > 0) {
+    if (!host->m_has_next) {
+      host->m_next_addr = next_addr(host);
+      host->m_next_write = m_pattern != TRAFFIC_GUPS && 
+                           host->m_rng.uniform() >= m_read_ratio;
+      host->m_has_next = true;
+    }
+
+    if (m_simBase->insert_request(host->m_next_addr, host->m_next_write, req,
+                                  host->m_host) == 0) {
+      return;
+    }
+    host->m_has_next = false;
+    host->m_due--;
+    host->m_issued++;
+    host->m_inserted++;
+  }
+}
+
+Addr traffic_gen_c::next_addr(traffic_host_s* host) {
+  Addr line_size = CFG(KNOB_RAMULATOR_CACHELINE_SIZE);
+  Addr footprint = m_lines * line_size;
+  Addr line = 0;
+
+  switch (m_pattern) {
+    case TRAFFIC_SEQ:
+    case TRAFFIC_STRIDE:
+      line = host->m_cursor / line_size;
+      host->m_cursor = (host->m_cursor + (m_pattern == TRAFFIC_SEQ ? line_size : m_stride)) 
+                       % footprint;
+      break;
+    case TRAFFIC_RANDOM:
+    case TRAFFIC_GUPS:
+      line = host->m_rng.next() % m_lines;
+      break;
+    case TRAFFIC_ZIPF: {
+      // scramble ranks so the hot lines do not share a dram row : every
+      // rank keeps a line of its own
+      uint64_t rank = m_zipf->sample(&host->m_rng) - 1;
+      unsigned __int128 scrambled = static_cast<unsigned __int128>(m_zipf_mul) * rank + 
+                                    m_zipf_add;
+      line = static_cast<Addr>(scrambled % m_lines);
+      break;
+    }
+    default:
+      break;
+  }
+
+  return m_base + line * line_size;
+}
+
+bool traffic_gen_c::finished() {
+  for (auto& host : m_hosts) {
+    if (host.m_issued < m_num_reqs || !host.m_updates.empty() || 
+        host.m_returned < host.m_inserted) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void traffic_gen_c::traffic_callback(Addr addr, bool write, Counter req_id, void *req) {
+  if (CFG(KNOB_DEBUG_CALLBACK)) {
+    std::cout << "======================== traffic callback ==============================" << std::endl;
+    std::cout << req_id << " " << addr << " " << write << " " << req << std::endl;
+  }
+
+  traffic_host_s* host = static_cast<traffic_host_s*>(req);
+  host->m_returned++;
+  if (m_pattern == TRAFFIC_GUPS && !write) {
+    host->m_updates.push_back(addr);
+  }
+}
+
+} // namespace CXL
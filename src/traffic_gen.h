@@ -0,0 +1,168 @@
+/*
+Copyright (c) <2021>, <Seoul National University> All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted
+provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of conditions
+and the following disclaimer.
+
+Redistributions in binary form must reproduce the above copyright notice, this list of
+conditions and the following disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+Neither the name of the <Georgia Institue of Technology> nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific prior
+written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+/**********************************************************************************************
+ * File         : traffic_gen.h
+ * Description  : Synthetic traffic generator (in place of the trace driven core)
+ *********************************************************************************************/
+
+#ifndef TRAFFIC_GEN_H
+#define TRAFFIC_GEN_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "global_types.h"
+#include "global_defs.h"
+
+namespace cxlsim {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// address streams
+typedef enum TRAFFIC_PATTERN {
+  TRAFFIC_SEQ = 0, /**< consecutive cachelines */
+  TRAFFIC_STRIDE,  /**< fixed stride (traffic_stride bytes) */
+  TRAFFIC_RANDOM,  /**< uniform random cachelines */
+  TRAFFIC_ZIPF,    /**< zipfian popularity over scrambled cachelines */
+  TRAFFIC_GUPS,    /**< random read, then a write of the same line once it returns */
+  MAX_TRAFFIC_PATTERNS
+} TRAFFIC_PATTERN;
+
+static const std::string traffic_pattern_string[MAX_TRAFFIC_PATTERNS] = {
+  "seq",
+  "stride",
+  "random",
+  "zipf",
+  "gups"
+};
+
+// issue models
+typedef enum TRAFFIC_ISSUE {
+  TRAFFIC_FIXED = 0, /**< open loop, traffic_rate requests per io cycle */
+  TRAFFIC_POISSON,   /**< open loop, poisson arrivals of mean traffic_rate */
+  TRAFFIC_CLOSED,    /**< closed loop, traffic_outstanding requests in flight */
+  MAX_TRAFFIC_ISSUES
+} TRAFFIC_ISSUE;
+
+static const std::string traffic_issue_string[MAX_TRAFFIC_ISSUES] = {
+  "fixed",
+  "poisson",
+  "closed"
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+// xorshift64* : same stream on every platform for a given seed
+typedef struct traffic_rng_s {
+  void seed(uint64_t seed);
+  uint64_t next();
+  double uniform(); /**< [0, 1) */
+
+  uint64_t m_state;
+} traffic_rng_s;
+
+// zipf ranks in [1, n] by rejection-inversion (hormann & derflinger),
+// constant time & memory for any number of elements
+class zipf_dist_c {
+public:
+  zipf_dist_c(uint64_t n, double alpha);
+  uint64_t sample(traffic_rng_s* rng);
+
+private:
+  double h(double x);
+  double h_integral(double x);
+  double h_integral_inverse(double x);
+
+private:
+  uint64_t m_n; /**< number of elements */
+  double m_alpha; /**< exponent */
+  double m_h_integral_x1;
+  double m_h_integral_n;
+  double m_s;
+};
+
+// traffic state of a host
+typedef struct traffic_host_s {
+  int m_host; /**< host (root complex) id */
+  traffic_rng_s m_rng; /**< address & read/write stream */
+  traffic_rng_s m_arrival_rng; /**< poisson inter-arrival times */
+  Addr m_cursor; /**< offset of the next seq/stride line */
+  double m_credit; /**< fixed rate : requests allowed to issue */
+  double m_next_arrival; /**< poisson : io cycle of the next arrival */
+  Counter m_due; /**< arrived requests not inserted yet */
+  bool m_has_next; /**< m_next_addr & m_next_write are generated */
+  Addr m_next_addr; /**< address of the next request */
+  bool m_next_write; /**< type of the next request */
+  Counter m_issued; /**< requests generated (gups : updates) */
+  Counter m_inserted; /**< requests inserted into cxlsim */
+  Counter m_returned; /**< requests returned */
+  std::list<Addr> m_updates; /**< gups writes waiting for insertion */
+} traffic_host_s;
+
+// generates requests on the fly & drives cxlsim like core_c
+class traffic_gen_c {
+public:
+  traffic_gen_c(cxlsim_c* simBase);
+  ~traffic_gen_c();
+
+  void run_a_cycle(bool pll_locked);
+  void run_sim();
+
+private:
+  traffic_gen_c(); // do not implement
+
+  void traffic_callback(Addr addr, bool write, Counter req_id, void *req);
+  void arrive(traffic_host_s* host); /**< add arrivals of this cycle to m_due */
+  void issue(traffic_host_s* host);
+  Addr next_addr(traffic_host_s* host);
+  bool finished();
+
+public:
+  cxlsim_c* m_simBase;
+  Counter m_cycle;
+
+private:
+  TRAFFIC_PATTERN m_pattern;
+  TRAFFIC_ISSUE m_issue;
+  Counter m_num_reqs; /**< requests (gups : updates) per host */
+  float m_read_ratio; /**< share of reads */
+  Addr m_base; /**< lowest address */
+  Addr m_lines; /**< footprint in cachelines */
+  Addr m_stride; /**< stride in bytes */
+  double m_rate; /**< open loop requests per io cycle of each host */
+  int m_outstanding; /**< closed loop requests in flight of each host */
+  zipf_dist_c* m_zipf;
+  Addr m_zipf_mul; /**< rank scramble multiplier (coprime to m_lines) */
+  Addr m_zipf_add; /**< rank scramble offset */
+  std::vector<traffic_host_s> m_hosts;
+};
+
+} //namespace CXL
+
+#endif //TRAFFIC_GEN_H